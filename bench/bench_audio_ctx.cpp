@@ -0,0 +1,91 @@
+// Benchmark: whisper encoder time versus utterance length, full 30 s context
+// against audio_ctx sized to the clip
+//
+// Usage: bench_audio_ctx <model.bin> [iterations] [threads]
+#include "transcription.h"
+#include <whisper.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+struct RunTiming {
+    double encodeMs = 0.0;
+    double totalMs = 0.0;
+};
+
+static RunTiming runWhisper(whisper_context* ctx, const std::vector<float>& audio, int audioCtx,
+                            int threads, int iterations) {
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads = threads;
+    params.audio_ctx = audioCtx;
+    params.language = "en";
+    params.print_progress = false;
+    params.print_realtime = false;
+
+    RunTiming timing;
+    whisper_reset_timings(ctx);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        whisper_full(ctx, params, audio.data(), static_cast<int>(audio.size()));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // whisper_get_timings reports per-call averages since the last reset, in a struct
+    // the caller owns
+    std::unique_ptr<whisper_timings> timings(whisper_get_timings(ctx));
+    timing.encodeMs = timings ? timings->encode_ms : 0.0;
+    timing.totalMs = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+    return timing;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <model.bin> [iterations] [threads]\n", argv[0]);
+        return 1;
+    }
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 3;
+    int threads = argc > 3 ? std::atoi(argv[3]) : 4;
+    const double lengths[] = {1.0, 2.0, 3.0, 4.0, 6.0, 10.0, 15.0, 30.0};
+    const int granularity = 64;
+    const int marginMs = 1000;
+
+    whisper_context_params contextParams = whisper_context_default_params();
+    whisper_context* ctx = whisper_init_from_file_with_params(argv[1], contextParams);
+    if (!ctx) {
+        std::fprintf(stderr, "Failed to load model %s\n", argv[1]);
+        return 1;
+    }
+
+    // Speech-like test signal; encoder cost depends only on its length
+    std::mt19937 rng(42);
+    std::normal_distribution<float> noise(0.0f, 0.01f);
+    std::vector<float> signal(static_cast<size_t>(30 * WHISPER_SAMPLE_RATE));
+    for (size_t i = 0; i < signal.size(); i++) {
+        float t = static_cast<float>(i) / WHISPER_SAMPLE_RATE;
+        float envelope = 0.5f + 0.5f * std::sin(2.0f * 3.14159265f * 3.0f * t);
+        signal[i] = envelope * (0.3f * std::sin(2.0f * 3.14159265f * 180.0f * t) +
+                                0.1f * std::sin(2.0f * 3.14159265f * 540.0f * t)) + noise(rng);
+    }
+
+    std::printf("%8s %10s %14s %14s %14s %14s %9s\n", "length", "audio_ctx",
+                "full enc (ms)", "full tot (ms)", "dyn enc (ms)", "dyn tot (ms)", "speedup");
+
+    for (double seconds : lengths) {
+        std::vector<float> clip(signal.begin(), signal.begin() + static_cast<size_t>(seconds * WHISPER_SAMPLE_RATE));
+        int audioCtx = computeAudioCtx(clip.size(), WHISPER_SAMPLE_RATE, marginMs, granularity);
+
+        RunTiming full = runWhisper(ctx, clip, 0, threads, iterations);
+        RunTiming dynamic = runWhisper(ctx, clip, audioCtx, threads, iterations);
+
+        std::printf("%7.1fs %10d %14.1f %14.1f %14.1f %14.1f %8.2fx\n", seconds, audioCtx,
+                    full.encodeMs, full.totalMs, dynamic.encodeMs, dynamic.totalMs,
+                    dynamic.encodeMs > 0.0 ? full.encodeMs / dynamic.encodeMs : 1.0);
+    }
+
+    whisper_free(ctx);
+    return 0;
+}
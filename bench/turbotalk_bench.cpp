@@ -0,0 +1,419 @@
+// Corpus benchmark: runs every WAV file in a directory through the real AudioManager
+// segmentation and Transcription path and reports real-time factor, per-utterance
+// latency percentiles, peak RSS and (where <name>.txt references exist) WER as JSON.
+//
+// Usage: turbotalk-bench [options] <corpus dir>
+#include "settings.h"
+#include "logger.h"
+#include "audio_manager.h"
+#include "file_audio_source.h"
+#include "transcription.h"
+#include "latency_tracker.h"
+#include "text_processing.h"
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static void printUsage() {
+    std::cerr << "Usage: turbotalk-bench [options] <corpus dir>\n"
+              << "\n"
+              << "Transcribes every .wav file in the directory (sorted by name). A <name>.txt\n"
+              << "next to a file is used as its reference transcript for WER.\n"
+              << "\n"
+              << "Options:\n"
+              << "  -s, --settings <file>     settings file (default: settings.json)\n"
+              << "  -m, --model <file>        override whisper.model_path\n"
+              << "  -t, --threads <n>         override whisper.threads\n"
+              << "  -o, --output <file>       write the JSON report here (default: stdout)\n"
+              << "      --throughput          queue chunks on all decoders instead of one at a time\n"
+              << "      --keep-latency-budget keep the adaptive decoding budget (timing-dependent,\n"
+              << "                            so results are no longer reproducible)\n"
+              << "  -h, --help                show this help\n";
+}
+
+// Words after the same normalization the command matcher uses
+static std::vector<std::string> splitWords(const std::string& text) {
+    std::vector<std::string> words;
+    std::istringstream stream(normalizeText(text));
+    std::string word;
+    while (stream >> word) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+// Word-level edit distance (substitutions + deletions + insertions)
+static size_t wordErrors(const std::vector<std::string>& reference, const std::vector<std::string>& hypothesis) {
+    std::vector<size_t> previous(hypothesis.size() + 1);
+    std::vector<size_t> current(hypothesis.size() + 1);
+    for (size_t j = 0; j <= hypothesis.size(); j++) {
+        previous[j] = j;
+    }
+    for (size_t i = 1; i <= reference.size(); i++) {
+        current[0] = i;
+        for (size_t j = 1; j <= hypothesis.size(); j++) {
+            size_t substitution = previous[j - 1] + (reference[i - 1] == hypothesis[j - 1] ? 0 : 1);
+            current[j] = std::min({substitution, previous[j] + 1, current[j - 1] + 1});
+        }
+        std::swap(previous, current);
+    }
+    return previous[hypothesis.size()];
+}
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+static double peakRssMb() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return usage.ru_maxrss / (1024.0 * 1024.0);  // bytes
+#else
+        return usage.ru_maxrss / 1024.0;             // kilobytes
+#endif
+    }
+#endif
+    return 0.0;
+}
+
+static double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    // Logs go to stderr so stdout only carries the report
+    Logger::initStderr();
+
+    std::string settingsPath = "settings.json";
+    std::string modelPath;
+    std::string outputPath;
+    std::string corpus;
+    int threads = 0;
+    bool throughput = false;
+    bool keepLatencyBudget = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((arg == "-s" || arg == "--settings") && hasValue) {
+            settingsPath = argv[++i];
+        } else if ((arg == "-m" || arg == "--model") && hasValue) {
+            modelPath = argv[++i];
+        } else if ((arg == "-t" || arg == "--threads") && hasValue) {
+            threads = std::atoi(argv[++i]);
+        } else if ((arg == "-o" || arg == "--output") && hasValue) {
+            outputPath = argv[++i];
+        } else if (arg == "--throughput") {
+            throughput = true;
+        } else if (arg == "--keep-latency-budget") {
+            keepLatencyBudget = true;
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (corpus.empty() && arg[0] != '-') {
+            corpus = arg;
+        } else {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (corpus.empty() || !fs::is_directory(corpus)) {
+        printUsage();
+        return 1;
+    }
+
+    Settings settings;
+    if (!settings.load(settingsPath)) {
+        Logger::error("Failed to load " + settingsPath);
+        return 1;
+    }
+    if (!modelPath.empty()) {
+        settings.modelPath = modelPath;
+    }
+    if (threads > 0) {
+        settings.threads = threads;
+    }
+
+    // Escalation decided by wall-clock time would make runs differ; the live app keeps it
+    if (!keepLatencyBudget) {
+        settings.adaptiveDecoding.latencyBudgetMs = 0;
+    }
+
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::directory_iterator(corpus)) {
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        if (entry.is_regular_file() && extension == ".wav") {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    if (files.empty()) {
+        Logger::error("No .wav files in " + corpus);
+        return 1;
+    }
+
+    // Load and warm up the model before anything is timed
+    auto loadStart = std::chrono::steady_clock::now();
+    Transcription transcription(settings);
+    transcription.init();
+    while (!transcription.isReady() && !transcription.hasFailed()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (transcription.hasFailed()) {
+        Logger::error("Failed to load " + settings.modelPath);
+        return 1;
+    }
+    double loadMs = msSince(loadStart);
+
+    nlohmann::json report;
+    report["config"] = {
+        {"model", settings.modelPath},
+        {"threads", settings.threads},
+        {"parallel_decoders", settings.parallelDecoders},
+        {"beam_size", settings.beamSize},
+        {"language", settings.language},
+        {"mode", throughput ? "throughput" : "stream"},
+        {"speech_detection", settings.speechDetection.enabled},
+        {"min_silence_ms", settings.speechDetection.minSilenceMs},
+        {"max_chunk_sec", settings.speechDetection.maxChunkSec},
+        {"dynamic_audio_ctx", settings.dynamicAudioCtx.enabled},
+        {"prompt_context", settings.promptContext.enabled},
+        {"adaptive_decoding", settings.adaptiveDecoding.enabled},
+        {"latency_budget_ms", settings.adaptiveDecoding.latencyBudgetMs},
+        {"incremental_mel", settings.incrementalMel.enabled},
+        {"fast_model", settings.fastModel.modelPath},
+        {"speech_gate", settings.speechGate.enabled}
+    };
+    report["model_load_ms"] = loadMs;
+
+    std::vector<double> latencies;
+    LatencyTracker latencyTracker(settings.sampleRate);
+    double totalAudioSeconds = 0.0;
+    double totalWallMs = 0.0;
+    double totalInferenceMs = 0.0;
+    size_t totalReferenceWords = 0;
+    size_t totalWordErrors = 0;
+    size_t totalUtterances = 0;
+    nlohmann::json fileReports = nlohmann::json::array();
+
+    for (const auto& path : files) {
+        std::unique_ptr<AudioSource> source = createFileAudioSource(path.string());
+        AudioManager audioManager(settings);
+        if (!source || !audioManager.init(std::move(source))) {
+            Logger::error("Skipping unreadable file " + path.string());
+            continue;
+        }
+        transcription.resetContext();
+
+        // A chunk in flight and when segmentation handed it over
+        struct Pending {
+            std::future<TranscriptionResult> result;
+            std::chrono::steady_clock::time_point readyTime;
+        };
+        std::deque<Pending> pending;
+        std::string hypothesis;
+        std::vector<double> fileLatencies;
+        double fileInferenceMs = 0.0;
+
+        // Results are collected in capture order, as the apps do
+        auto collect = [&](bool wait) {
+            while (!pending.empty() &&
+                   (wait || pending.front().result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+                Pending next = std::move(pending.front());
+                pending.pop_front();
+                TranscriptionResult result = next.result.get();
+                double latencyMs = msSince(next.readyTime);
+                transcription.commitContext(result);
+                fileLatencies.push_back(latencyMs);
+                fileInferenceMs += result.inferenceMs;
+
+                ChunkTiming timing = result.timing;
+                std::string text = cleanTranscription(result.text);
+                timing.postProcessed = ChunkTiming::Clock::now();
+                if (!text.empty()) {
+                    hypothesis += (hypothesis.empty() ? "" : " ") + text;
+                }
+                timing.output = ChunkTiming::Clock::now();
+                latencyTracker.record(timing);
+            }
+        };
+
+        auto fileStart = std::chrono::steady_clock::now();
+        audioManager.setContinuousMode(true);
+        audioManager.startRecording();
+        // In throughput mode a chunk whose queue is full waits here rather than in submit()
+        AudioChunk held;
+        while (!audioManager.isEndOfStream() || audioManager.hasNewContinuousAudio() || !held.empty()) {
+            collect(false);
+            if (held.empty()) {
+                if (!audioManager.hasNewContinuousAudio()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+                held = audioManager.getContinuousAudioChunk();
+                if (held.empty()) {
+                    continue;
+                }
+            }
+            if (throughput && !transcription.canSubmit(held)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            Pending next;
+            next.readyTime = std::chrono::steady_clock::now();
+            next.result = transcription.submit(std::move(held), true);
+            held = AudioChunk();
+            pending.push_back(std::move(next));
+
+            // Stream mode decodes one chunk at a time
+            if (!throughput) {
+                collect(true);
+            }
+        }
+        collect(true);
+        audioManager.stopRecording();
+        double wallMs = msSince(fileStart);
+
+        double audioSeconds = static_cast<double>(audioManager.getStreamPosition()) / settings.sampleRate;
+        ChunkQueueStats queue = audioManager.getChunkQueueStats();
+        nlohmann::json fileReport = {
+            {"file", path.filename().string()},
+            {"audio_seconds", audioSeconds},
+            {"wall_ms", wallMs},
+            {"rtf", audioSeconds > 0.0 ? wallMs / 1000.0 / audioSeconds : 0.0},
+            {"utterances", fileLatencies.size()},
+            {"latency_p50_ms", percentile(fileLatencies, 50)},
+            {"latency_max_ms", percentile(fileLatencies, 100)},
+            {"queue_peak_chunks", queue.peakDepth},
+            {"queue_peak_seconds", queue.peakQueuedSeconds},
+            {"hypothesis", hypothesis}
+        };
+
+        fs::path referencePath = path;
+        referencePath.replace_extension(".txt");
+        std::ifstream referenceFile(referencePath);
+        if (referenceFile) {
+            std::stringstream buffer;
+            buffer << referenceFile.rdbuf();
+            std::vector<std::string> referenceWords = splitWords(buffer.str());
+            size_t errors = wordErrors(referenceWords, splitWords(hypothesis));
+            fileReport["reference_words"] = referenceWords.size();
+            fileReport["word_errors"] = errors;
+            fileReport["wer"] = referenceWords.empty() ? 0.0 : static_cast<double>(errors) / referenceWords.size();
+            totalReferenceWords += referenceWords.size();
+            totalWordErrors += errors;
+        }
+        fileReports.push_back(fileReport);
+
+        Logger::info(path.filename().string() + ": " + std::to_string(audioSeconds) + " s audio in " +
+                     std::to_string(static_cast<int>(wallMs)) + " ms");
+        latencies.insert(latencies.end(), fileLatencies.begin(), fileLatencies.end());
+        totalAudioSeconds += audioSeconds;
+        totalWallMs += wallMs;
+        totalInferenceMs += fileInferenceMs;
+        totalUtterances += fileLatencies.size();
+    }
+
+    double meanLatency = 0.0;
+    for (double latency : latencies) {
+        meanLatency += latency;
+    }
+    meanLatency = latencies.empty() ? 0.0 : meanLatency / latencies.size();
+
+    report["files"] = fileReports;
+    report["totals"] = {
+        {"files", fileReports.size()},
+        {"audio_seconds", totalAudioSeconds},
+        {"wall_ms", totalWallMs},
+        {"rtf", totalAudioSeconds > 0.0 ? totalWallMs / 1000.0 / totalAudioSeconds : 0.0},
+        {"inference_rtf", totalAudioSeconds > 0.0 ? totalInferenceMs / 1000.0 / totalAudioSeconds : 0.0},
+        {"throughput_x_realtime", totalWallMs > 0.0 ? totalAudioSeconds / (totalWallMs / 1000.0) : 0.0},
+        {"utterances", totalUtterances},
+        {"latency_ms", {
+            {"mean", meanLatency},
+            {"p50", percentile(latencies, 50)},
+            {"p90", percentile(latencies, 90)},
+            {"p95", percentile(latencies, 95)},
+            {"p99", percentile(latencies, 99)},
+            {"max", percentile(latencies, 100)}
+        }},
+        {"peak_rss_mb", peakRssMb()}
+    };
+
+    // Where the latency went, stage by stage (percentiles are histogram bucket bounds)
+    nlohmann::json stages = nlohmann::json::object();
+    for (int i = 0; i < LatencyTracker::STAGE_COUNT; i++) {
+        LatencyTracker::Stage stage = static_cast<LatencyTracker::Stage>(i);
+        LatencyTracker::Summary summary = latencyTracker.summary(stage);
+        stages[LatencyTracker::stageName(stage)] = {
+            {"count", summary.count},
+            {"mean", summary.meanMs},
+            {"p50", summary.p50Ms},
+            {"p90", summary.p90Ms},
+            {"p99", summary.p99Ms},
+            {"max", summary.maxMs}
+        };
+    }
+    report["totals"]["stages_ms"] = stages;
+
+    SpeechGateStats gate = transcription.getSpeechGateStats();
+    report["totals"]["speech_gate"] = {
+        {"checked", gate.checked},
+        {"low_energy", gate.lowEnergy},
+        {"unvoiced", gate.unvoiced},
+        {"no_speech", gate.noSpeech},
+        {"early_stops", gate.earlyStops},
+        {"no_speech_segments", gate.noSpeechSegments},
+        {"skipped_audio_seconds", gate.skippedAudioSeconds}
+    };
+    if (totalReferenceWords > 0) {
+        report["totals"]["reference_words"] = totalReferenceWords;
+        report["totals"]["word_errors"] = totalWordErrors;
+        report["totals"]["wer"] = static_cast<double>(totalWordErrors) / totalReferenceWords;
+    }
+
+    if (outputPath.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream output(outputPath);
+        if (!output) {
+            Logger::error("Cannot write " + outputPath);
+            return 1;
+        }
+        output << report.dump(2) << std::endl;
+    }
+
+    transcription.logRouteStats();
+    return 0;
+}
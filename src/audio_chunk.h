@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Log-mel spectrogram in whisper's layout: nMels rows of nFrames values each
+struct MelFrames {
+    std::vector<float> data;
+    int nMels = 0;
+    int nFrames = 0;
+
+    bool empty() const { return data.empty(); }
+};
+
+// Where one utterance spent its time between the user and the screen. Sample
+// positions are on the capture clock (AudioManager::getStreamPosition); the rest are
+// wall-clock instants, left default-constructed until the stage is reached.
+struct ChunkTiming {
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t speechStartSample = 0;  // Speech onset
+    uint64_t speechEndSample = 0;    // Last block that still sounded like speech
+    uint64_t endpointSample = 0;     // Where the chunk was closed
+    Clock::time_point endpoint;      // Chunk closed and queued by the capture side
+    Clock::time_point enqueue;       // Submitted for transcription
+    Clock::time_point decodeStart;   // A worker picked it up
+    Clock::time_point decodeEnd;     // Whisper finished
+    Clock::time_point postProcessed; // Text cleaned and commands resolved
+    Clock::time_point output;        // Typed, executed or printed
+
+    static bool isSet(Clock::time_point t) { return t.time_since_epoch().count() != 0; }
+};
+
+// A piece of captured audio ready for transcription, with its spectrogram if the
+// capture thread already computed one
+struct AudioChunk {
+    std::vector<float> samples;
+    MelFrames mel;
+    ChunkTiming timing;
+    bool preferFast = false;  // Queue overflow: decode on the fast model if one is loaded
+    float voicedThreshold = 0.0f;  // RMS the producer treats as speech; 0 means speech_detection.threshold
+
+    bool empty() const { return samples.empty(); }
+};
@@ -1,24 +1,26 @@
 #include "audio_manager.h"
 #include "logger.h"
+#include "trace.h"
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 
 AudioManager::AudioManager(Settings& settings) 
-    : settings(settings), deviceId(0), recording(false), 
+    : settings(settings), recording(false), 
+      ringBuffer(static_cast<size_t>(settings.sampleRate) * settings.ringBufferMs / 1000),
       continuousMode(false), newContinuousAudioAvailable(false),
       newContinuousAudioReady(false),
       continuousSampleThreshold(settings.sampleRate * 2.5), // 2.5 seconds of audio
       silenceThreshold(settings.silenceThreshold),
       silenceDurationSamples(settings.silenceDurationMs * settings.sampleRate / 1000),
       sampleRate(settings.sampleRate),
-      silenceCounter(0),
-      silenceChunks(settings.silenceDurationMs * settings.sampleRate / (1000 * 1024)), // Convert ms to buffer chunks
+      silenceSampleCount(0),
       // Speech detection initialization with safe defaults
       currentSpeechState(SpeechState::SILENCE),
       speechThreshold(0.02f), // Safe default
-      minSilenceFrames(settings.sampleRate / (1024) * 1000 / 1000), // ~1 second
-      minSpeechFrames(settings.sampleRate / 50), // About 20ms of speech
-      maxSpeechFrames(settings.sampleRate * 15), // 15 seconds max
+      minSilenceSamples(settings.sampleRate), // 1 second
+      minSpeechSamples(settings.sampleRate / 50), // About 20ms of speech
+      maxSpeechSamples(settings.sampleRate * 15), // 15 seconds max
       preSpeechBufferSize(settings.sampleRate / 2), // 0.5 seconds
       speechDetectionEnabled(true),
       currentAudioLevel(0.0f) {
@@ -29,108 +31,169 @@ AudioManager::AudioManager(Settings& settings)
     }
     
     if (settings.speechDetection.minSilenceMs > 0) {
-        minSilenceFrames = settings.speechDetection.minSilenceMs * settings.sampleRate / (1000 * 1024);
+        minSilenceSamples = settings.speechDetection.minSilenceMs * settings.sampleRate / 1000;
+    }
+    
+    commandMinSilenceSamples = minSilenceSamples;
+    if (settings.speechDetection.commandMinSilenceMs > 0) {
+        commandMinSilenceSamples = settings.speechDetection.commandMinSilenceMs * settings.sampleRate / 1000;
     }
     
     if (settings.speechDetection.maxChunkSec > 0) {
-        maxSpeechFrames = settings.speechDetection.maxChunkSec * settings.sampleRate;
+        maxSpeechSamples = settings.speechDetection.maxChunkSec * settings.sampleRate;
     }
     
+    splitSearchSamples = static_cast<size_t>(std::max(settings.speechDetection.splitSearchMs, 0)) * sampleRate / 1000;
+    splitOverlapSamples = static_cast<size_t>(std::max(settings.speechDetection.splitOverlapMs, 0)) * sampleRate / 1000;
+    
     if (settings.speechDetection.preSpeechBufferMs > 0) {
         preSpeechBufferSize = settings.speechDetection.preSpeechBufferMs * settings.sampleRate / 1000;
     }
     
+    if (settings.speechDetection.maxZeroCrossingRate > 0) {
+        maxSpeechZeroCrossingRate = settings.speechDetection.maxZeroCrossingRate;
+    }
+    
     speechDetectionEnabled = settings.speechDetection.enabled;
     
-    // Initialize desired audio spec
-    SDL_zero(desiredSpec);
-    desiredSpec.freq = settings.sampleRate;
-    desiredSpec.format = AUDIO_F32;
-    desiredSpec.channels = 1;
-    desiredSpec.samples = 1024; // Buffer size
-    desiredSpec.callback = AudioManager::audioCallback;
-    desiredSpec.userdata = this;
+    // Bound the push-to-talk recording buffer
+    const size_t bytesPerMb = 1024 * 1024;
+    captureBudgetBytes = static_cast<size_t>(settings.capture.maxMemoryMb) * bytesPerMb;
+    audioBuffer.configure(captureBudgetBytes / sizeof(float),
+                          settings.capture.spillToDisk,
+                          static_cast<size_t>(settings.capture.maxSpillMb) * bytesPerMb / sizeof(float),
+                          settings.capture.spillDir);
+    
+    // Sentences of a push-to-talk recording end at a pause
+    segmentPipelining = settings.pushToTalkPipeline.enabled && settings.pushToTalkPipeline.pauseMs > 0;
+    segmentPauseSamples = settings.pushToTalkPipeline.pauseMs * sampleRate / 1000;
+    minSegmentSamples = static_cast<size_t>(std::max(settings.pushToTalkPipeline.minSegmentSec, 0.0f) * sampleRate);
     
-    // Pre-allocate the pre-speech buffer
-    preSpeechBuffer.reserve(preSpeechBufferSize);
+    // Bound the continuous chunk queue
+    const Settings::ChunkQueueSettings& queue = settings.chunkQueue;
+    maxQueuedSamples = queue.maxQueuedSec > 0 ? static_cast<size_t>(queue.maxQueuedSec * sampleRate) : 0;
+    maxMergedSamples = static_cast<size_t>(std::max(queue.maxMergedSec, 0.0f) * sampleRate);
+    warnAgeMs = queue.warnAgeSec * 1000.0;
+    if (queue.policy == "merge") {
+        queuePolicy = QueuePolicy::MERGE;
+    } else if (queue.policy == "drop_oldest") {
+        queuePolicy = QueuePolicy::DROP_OLDEST;
+    } else if (queue.policy == "fast_model") {
+        queuePolicy = QueuePolicy::FAST_MODEL;
+    } else if (queue.policy == "none") {
+        queuePolicy = QueuePolicy::NONE;
+    } else {
+        Logger::error("Unknown chunk_queue.policy '" + queue.policy + "', using merge");
+        queuePolicy = QueuePolicy::MERGE;
+    }
+    
+    // Allocate the fixed-capacity pre-speech ring once
+    preSpeechBuffer.reset(preSpeechBufferSize);
+    
+    // Spectrograms for the recording and the speech chunks, if enabled. They use the
+    // model's own filterbank so they match what whisper would compute from the PCM; a
+    // speech chunk's spectrogram is bounded by max_chunk_sec, the recording's by the
+    // capture memory budget.
+    incrementalMel = settings.incrementalMel.enabled;
+    if (incrementalMel) {
+        recordingMel = MelSpectrogram(settings.incrementalMel.nMels);
+        chunkMel = MelSpectrogram(settings.incrementalMel.nMels);
+        if (!recordingMel.loadModelFilters(settings.modelPath) || !chunkMel.loadModelFilters(settings.modelPath)) {
+            Logger::error("No " + std::to_string(settings.incrementalMel.nMels) + "-band mel filters in " +
+                          settings.modelPath + ", incremental mel disabled");
+            incrementalMel = false;
+        }
+    }
 }
 
 AudioManager::~AudioManager() {
-    if (deviceId != 0) {
-        SDL_CloseAudioDevice(deviceId);
+    // Release the source first so no more samples arrive
+    recording.store(false);
+    if (source) {
+        source->close();
+    }
+    
+    processingActive.store(false);
+    if (processingThread.joinable()) {
+        processingThread.join();
     }
 }
 
-bool AudioManager::init() {
-    // List all available audio input devices
-    int numDevices = SDL_GetNumAudioDevices(1); // 1 indicates capture devices
-    Logger::info("Available audio input devices:");
-    for (int i = 0; i < numDevices; i++) {
-        const char* name = SDL_GetAudioDeviceName(i, 1);
-        Logger::info(std::to_string(i) + ": " + name);
+bool AudioManager::init(std::unique_ptr<AudioSource> audioSource) {
+    source = std::move(audioSource);
+    if (!source || !source->open(sampleRate, this)) {
+        Logger::error("Failed to open audio source");
+        return false;
     }
 
-    // Determine which device to use
-    std::string deviceToUse = settings.audioDevice;
-    if (deviceToUse.empty() && numDevices > 0) {
-        // If the device setting is empty, use the first available
-        deviceToUse = SDL_GetAudioDeviceName(0, 1);
-        Logger::info("Using first available device: " + deviceToUse);
-    }
+    Logger::info("Audio source: " + source->describe());
+    Logger::info("Capture ring buffer: " + std::to_string(ringBuffer.capacity()) + " samples");
+    Logger::info("Audio feature kernel: " + std::string(blockStatsKernelName()));
 
-    // If the device is "default", pass NULL to use the system's default device
-    const char* deviceName = (deviceToUse == "default") ? NULL : deviceToUse.c_str();
-    Logger::info("Opening audio device: " + std::string(deviceName ? deviceName : "default"));
+    // Process audio in blocks matching the source's delivery size
+    blockSize = source->blockSize();
 
-    // Attempt to open the audio device
-    deviceId = SDL_OpenAudioDevice(deviceName, 1, &desiredSpec, &obtainedSpec, 0);
-    if (deviceId == 0) {
-        // If it fails, log the error and list devices again for reference
-        Logger::error("Failed to open audio device: " + std::string(SDL_GetError()));
-        Logger::error("Available audio input devices:");
-        for (int i = 0; i < numDevices; i++) {
-            const char* name = SDL_GetAudioDeviceName(i, 1);
-            Logger::error(std::to_string(i) + ": " + name);
-        }
-        return false;
-    }
-
-    Logger::info("Audio device opened successfully");
-    Logger::info("Sample rate: " + std::to_string(obtainedSpec.freq));
-    Logger::info("Channels: " + std::to_string(obtainedSpec.channels));
-    Logger::info("Format: " + std::to_string(obtainedSpec.format));
-    Logger::info("Samples per chunk: " + std::to_string(obtainedSpec.samples));
+    // Start the consumer thread that runs level detection, VAD and chunking
+    processingActive.store(true);
+    processingThread = std::thread(&AudioManager::processingLoop, this);
 
     return true;
 }
 
 void AudioManager::startRecording() {
     if (!recording) {
+        std::lock_guard<std::mutex> lock(audioMutex);
         audioBuffer.clear();
+        recordingMel.reset();
+        recordingMelActive = incrementalMel;
         continuousBuffer.clear();
-        silenceCounter = 0;
+        silenceSampleCount = 0;
+        recordingStartSample = streamPosition.load();
+        recordingSegments.clear();
+        recordingSegmentCount.store(0);
+        segmentStart = 0;
+        takenSamples = 0;
+        segmentClosedInPause = false;
         
         // Initialize speech detection state
         currentSpeechState.store(SpeechState::SILENCE);
-        silenceFrameCount = 0;
-        speechFrameCount = 0;
+        silenceSamples = 0;
+        speechSamples = 0;
         preSpeechBuffer.clear();
         currentSpeechBuffer.clear();
         
-        SDL_PauseAudioDevice(deviceId, 0);
+        // Accept samples before the source starts delivering them
         recording = true;
-        lastContinuousProcessTime = std::chrono::steady_clock::now();
+        source->start();
         Logger::info("Recording started" + std::string(continuousMode ? " (continuous mode)" : ""));
     }
 }
 
 void AudioManager::stopRecording() {
     if (recording) {
-        SDL_PauseAudioDevice(deviceId, 1);
+        // Clearing the flag first releases a file source blocked in pushBlocking()
         recording = false;
+        source->stop();
+        
+        // Let the processing thread catch up so getAudioData() sees everything
+        waitForDrain();
         continuousMode = false;
         newContinuousAudioReady = false;
         Logger::info("Recording stopped");
+        
+        CaptureStats stats = getCaptureStats();
+        Logger::info("Capture stats: captured " + std::to_string(stats.capturedSamples) +
+                     ", processed " + std::to_string(stats.processedSamples) +
+                     ", dropped " + std::to_string(stats.droppedSamples) +
+                     " (" + std::to_string(stats.overruns) + " overruns)" +
+                     ", ring high water " + std::to_string(stats.ringHighWater) +
+                     "/" + std::to_string(stats.ringCapacity));
+        
+        std::lock_guard<std::mutex> lock(audioMutex);
+        Logger::info("Capture buffer: " + std::to_string(audioBuffer.bufferedBytes() / 1024) + " KB" +
+                     " (peak " + std::to_string(audioBuffer.peakBytes() / 1024) + " KB" +
+                     (audioBuffer.isSpilled() ? ", spilled to disk" : "") +
+                     ", dropped " + std::to_string(audioBuffer.droppedSamples()) + " samples)");
     }
 }
 
@@ -139,14 +202,97 @@ bool AudioManager::isRecording() const {
 }
 
 std::vector<float> AudioManager::getAudioData() const {
-    return audioBuffer;
+    std::lock_guard<std::mutex> lock(audioMutex);
+    return audioBuffer.data();
+}
+
+AudioChunk AudioManager::getRecording() {
+    TRACE_SCOPE("AudioManager::getRecording");
+    std::lock_guard<std::mutex> lock(audioMutex);
+    AudioChunk chunk;
+    
+    // Segments nobody took stay part of what is returned
+    size_t start = std::min(takenSamples, audioBuffer.size());
+    if (start == 0) {
+        chunk.samples = audioBuffer.data();
+    } else {
+        chunk.samples.resize(audioBuffer.size() - start);
+        audioBuffer.copyRange(start, chunk.samples.size(), chunk.samples.data());
+    }
+    recordingSegments.clear();
+    recordingSegmentCount.store(0);
+    chunk.voicedThreshold = silenceThreshold;
+    
+    // The spectrogram only applies if it saw exactly the samples that were kept
+    if (recordingMelActive && !audioBuffer.isSpilled() && audioBuffer.droppedSamples() == 0 &&
+        recordingMel.sampleCount() == chunk.samples.size()) {
+        chunk.mel = recordingMel.finish();
+    } else {
+        recordingMel.reset();
+    }
+    
+    // Auto-stop fires after a stretch of silence, which is endpointing delay too
+    uint64_t end = streamPosition.load();
+    uint64_t begin = recordingStartSample + start;
+    uint64_t trailingSilence = std::min<uint64_t>(static_cast<uint64_t>(silenceSampleCount), end - std::min(end, begin));
+    chunk.timing = closeTiming(begin, end - trailingSilence);
+    return chunk;
+}
+
+bool AudioManager::hasRecordingSegment() const {
+    return recordingSegmentCount.load() > 0;
+}
+
+AudioChunk AudioManager::takeRecordingSegment() {
+    std::lock_guard<std::mutex> lock(audioMutex);
+    if (recordingSegments.empty()) {
+        return AudioChunk();
+    }
+    RecordingSegment segment = std::move(recordingSegments.front());
+    recordingSegments.pop_front();
+    recordingSegmentCount.store(recordingSegments.size());
+    takenSamples = segment.end;
+    return std::move(segment.chunk);
+}
+
+// Called with audioMutex held once a pause has lasted segmentPauseSamples. The cut goes
+// in the middle of the pause so both sides keep some silence; a stretch shorter than
+// minSegmentSamples is left to grow into the next sentence.
+void AudioManager::closeRecordingSegment() {
+    segmentClosedInPause = true;
+    size_t size = audioBuffer.size();
+    size_t cut = size - std::min(size, static_cast<size_t>(silenceSampleCount) / 2);
+    if (cut <= segmentStart || cut - segmentStart < minSegmentSamples) {
+        return;
+    }
+    
+    RecordingSegment segment;
+    segment.end = cut;
+    segment.chunk.samples.resize(cut - segmentStart);
+    audioBuffer.copyRange(segmentStart, segment.chunk.samples.size(), segment.chunk.samples.data());
+    uint64_t end = streamPosition.load();
+    uint64_t speechEnd = end - std::min<uint64_t>(static_cast<uint64_t>(silenceSampleCount), end - recordingStartSample);
+    segment.chunk.timing = closeTiming(recordingStartSample + segmentStart, speechEnd);
+    segment.chunk.voicedThreshold = silenceThreshold;
+    Logger::info("Push-to-talk segment ready: " +
+                 std::to_string(static_cast<double>(cut - segmentStart) / sampleRate).substr(0, 4) + " s");
+    
+    recordingSegments.push_back(std::move(segment));
+    recordingSegmentCount.store(recordingSegments.size());
+    segmentStart = cut;
 }
 
 bool AudioManager::checkSilence() {
-    return silenceCounter >= silenceChunks;
+    return silenceSampleCount >= silenceDurationSamples;
+}
+
+void AudioManager::setCommandMode(bool enabled) {
+    commandMode.store(enabled);
 }
 
 void AudioManager::setContinuousMode(bool enabled) {
+    // Hold the processing lock so the consumer thread never sees half-reset state
+    std::lock_guard<std::mutex> audioLock(audioMutex);
     continuousMode.store(enabled);
     
     if (enabled) {
@@ -156,8 +302,8 @@ void AudioManager::setContinuousMode(bool enabled) {
         if (speechDetectionEnabled && settings.speechDetection.enabled) {
             Logger::info("Speech-aware chunking enabled");
             currentSpeechState.store(SpeechState::SILENCE);
-            silenceFrameCount = 0;
-            speechFrameCount = 0;
+            silenceSamples = 0;
+            speechSamples = 0;
             preSpeechBuffer.clear();
             currentSpeechBuffer.clear();
         }
@@ -167,6 +313,8 @@ void AudioManager::setContinuousMode(bool enabled) {
         
         std::lock_guard<std::mutex> lock(continuousMutex);
         continuousChunks.clear();
+        queuedSamples.store(0);
+        queueStats.fallingBehind = false;
     } else {
         Logger::info("Continuous mode disabled");
         
@@ -186,7 +334,7 @@ bool AudioManager::hasNewContinuousAudio() {
     return newContinuousAudioAvailable.load();
 }
 
-std::vector<float> AudioManager::getContinuousAudioChunk() {
+AudioChunk AudioManager::getContinuousAudioChunk() {
     std::lock_guard<std::mutex> lock(continuousMutex);
     
     // If no chunks available, return empty
@@ -195,8 +343,10 @@ std::vector<float> AudioManager::getContinuousAudioChunk() {
     }
     
     // Get the oldest chunk
-    std::vector<float> chunk = std::move(continuousChunks.front());
+    AudioChunk chunk = std::move(continuousChunks.front());
     continuousChunks.pop_front();
+    queuedSamples.fetch_sub(chunk.samples.size());
+    updateQueueHealth();
     
     // Reset flag if no more chunks
     if (continuousChunks.empty()) {
@@ -210,52 +360,191 @@ void AudioManager::resetContinuousFlag() {
     newContinuousAudioAvailable.store(false);
 }
 
-// Static audio callback
-void AudioManager::audioCallback(void* userdata, Uint8* stream, int len) {
-    AudioManager* am = static_cast<AudioManager*>(userdata);
-    am->processAudioData(stream, len);
+// Real-time delivery from the device thread: only copies the samples into
+// the preallocated ring and never locks, allocates or waits
+void AudioManager::pushRealtime(const float* samples, size_t numSamples) {
+    if (!recording.load(std::memory_order_relaxed)) return;
+    
+    size_t written = ringBuffer.write(samples, numSamples);
+    
+    capturedSamples.fetch_add(numSamples, std::memory_order_relaxed);
+    if (written < numSamples) {
+        droppedSamples.fetch_add(numSamples - written, std::memory_order_relaxed);
+        overrunCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Paced delivery from a file/pipe reader: wait for ring space instead of dropping,
+// so the stream is processed as fast as the consumer keeps up
+size_t AudioManager::pushBlocking(const float* samples, size_t numSamples) {
+    size_t total = 0;
+    while (total < numSamples && recording.load()) {
+        size_t written = ringBuffer.write(samples + total, numSamples - total);
+        capturedSamples.fetch_add(written);
+        total += written;
+        if (total < numSamples) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return total;
 }
 
-// Check if sound level indicates speech
-bool AudioManager::detectSpeech(float soundLevel) {
-    return soundLevel > speechThreshold;
+// The source delivered its last sample; the processing thread finishes up
+void AudioManager::endOfStream() {
+    endOfStreamPending.store(true);
 }
 
-// Update speech state based on current sound level
-void AudioManager::updateSpeechState(float soundLevel) {
-    bool isSpeech = detectSpeech(soundLevel);
+// Consumer thread: pull fixed-size blocks from the ring and run them through
+// level detection, silence detection and speech-aware chunking
+void AudioManager::processingLoop() {
+    Trace::setThreadName("audio processing");
+    std::vector<float> block(blockSize);
+    
+    while (processingActive.load()) {
+        size_t ready = ringBuffer.available();
+        if (ready > ringHighWater.load(std::memory_order_relaxed)) {
+            ringHighWater.store(ready, std::memory_order_relaxed);
+        }
+        
+        // Only handle whole blocks unless a drain was requested or the stream ended
+        bool flushing = flushRequested.load() || endOfStreamPending.load();
+        if (ready < static_cast<size_t>(blockSize) && !(flushing && ready > 0)) {
+            if (ready == 0 && endOfStreamPending.load() && !streamEnded.load()) {
+                std::lock_guard<std::mutex> lock(audioMutex);
+                finishStream();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+        
+        // Files and pipes wait for transcription to catch up rather than queue without bound
+        if (isBackpressured()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+        
+        size_t numSamples = ringBuffer.read(block.data(), block.size());
+        {
+            std::lock_guard<std::mutex> lock(audioMutex);
+            processAudioData(block.data(), static_cast<int>(numSamples));
+        }
+        processedSamples.fetch_add(numSamples);
+    }
+}
+
+// Block until the processing thread has consumed everything captured so far
+void AudioManager::waitForDrain() {
+    if (!processingActive.load()) return;
+    
+    flushRequested.store(true);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (processedSamples.load() + droppedSamples.load() < capturedSamples.load()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            Logger::error("Timed out waiting for audio processing to drain");
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    flushRequested.store(false);
+}
+
+// Queue whatever is still buffered once a file/pipe source has ended (audioMutex is held)
+void AudioManager::finishStream() {
+    if (continuousMode.load()) {
+        if (speechDetectionEnabled && settings.speechDetection.enabled) {
+            if (currentSpeechState.load() == SpeechState::SPEAKING) {
+                processSpeechBasedChunk();
+                currentSpeechState.store(SpeechState::SILENCE);
+            }
+        } else if (!continuousBuffer.empty()) {
+            uint64_t end = streamPosition.load();
+            AudioChunk chunk;
+            chunk.timing = closeTiming(end - continuousBuffer.size(), end);
+            chunk.samples = std::move(continuousBuffer);
+            continuousBuffer = std::vector<float>();
+            enqueueChunk(std::move(chunk));
+        }
+    }
+    
+    streamEnded.store(true);
+    Logger::info("End of audio stream at " + std::to_string(streamPosition.load() / sampleRate) + " s");
+}
+
+uint64_t AudioManager::getStreamPosition() const {
+    return streamPosition.load();
+}
+
+bool AudioManager::isEndOfStream() const {
+    return streamEnded.load();
+}
+
+// Get capture ring buffer counters
+CaptureStats AudioManager::getCaptureStats() const {
+    CaptureStats stats;
+    stats.capturedSamples = capturedSamples.load();
+    stats.processedSamples = processedSamples.load();
+    stats.droppedSamples = droppedSamples.load();
+    stats.overruns = overrunCount.load();
+    stats.ringCapacity = ringBuffer.capacity();
+    stats.ringHighWater = ringHighWater.load();
+    return stats;
+}
+
+// Check if a block looks like speech: loud enough, and not noise-like if a ZCR limit is set
+bool AudioManager::detectSpeech(const AudioBlockStats& stats) {
+    if (stats.rms() <= speechThreshold) {
+        return false;
+    }
+    
+    // Broadband noise (fans, hiss) crosses zero far more often than voiced speech
+    if (maxSpeechZeroCrossingRate > 0.0f && stats.zeroCrossingRate() > maxSpeechZeroCrossingRate) {
+        return false;
+    }
+    
+    return true;
+}
+
+// Update speech state based on the latest block statistics
+void AudioManager::updateSpeechState(const AudioBlockStats& stats) {
+    TRACE_SCOPE("AudioManager::updateSpeechState");
+    bool isSpeech = detectSpeech(stats);
+    int blockSamples = static_cast<int>(stats.sampleCount);
     
     switch (currentSpeechState) {
         case SpeechState::SILENCE:
             if (isSpeech) {
                 // Potential speech detected
-                speechFrameCount++;
-                if (speechFrameCount >= minSpeechFrames) {
+                speechSamples += blockSamples;
+                if (speechSamples >= minSpeechSamples) {
                     // Transition to SPEAKING state
                     currentSpeechState.store(SpeechState::SPEAKING);
-                    speechFrameCount = 0;
-                    silenceFrameCount = 0;
+                    speechSamples = 0;
+                    silenceSamples = 0;
+                    
+                    // Record where in the stream speech started
+                    speechStartSample = streamPosition.load();
+                    lastSpeechSample = speechStartSample;
                     
-                    // Record when speech started
-                    speechStartTime = std::chrono::steady_clock::now();
+                    // Seed the new chunk with the audio leading up to the speech
+                    beginSpeechChunk();
                     
                     Logger::info("Speech detected - starting new chunk");
                 }
             } else {
                 // Still silence, add to pre-speech buffer
-                speechFrameCount = 0;
+                speechSamples = 0;
             }
             break;
             
         case SpeechState::SPEAKING:
             if (!isSpeech) {
                 // Potential silence detected
-                silenceFrameCount++;
-                if (silenceFrameCount >= minSilenceFrames) {
+                silenceSamples += blockSamples;
+                if (silenceSamples >= (commandMode.load() ? commandMinSilenceSamples : minSilenceSamples)) {
                     // Transition to SILENCE state and process the speech chunk
                     currentSpeechState.store(SpeechState::SILENCE);
-                    silenceFrameCount = 0;
-                    speechFrameCount = 0;
+                    silenceSamples = 0;
+                    speechSamples = 0;
                     
                     // Process the completed speech chunk
                     processSpeechBasedChunk();
@@ -264,19 +553,14 @@ void AudioManager::updateSpeechState(float soundLevel) {
                 }
             } else {
                 // Still speaking
-                silenceFrameCount = 0;
+                silenceSamples = 0;
+                lastSpeechSample = streamPosition.load();
                 
                 // Check if we've exceeded maximum chunk duration
-                auto now = std::chrono::steady_clock::now();
-                auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - speechStartTime).count();
-                
-                if (duration >= settings.speechDetection.maxChunkSec) {
-                    // Force processing of the current chunk if it's too long
-                    Logger::info("Max speech duration reached - splitting chunk");
-                    processSpeechBasedChunk();
-                    
-                    // Reset timers but remain in SPEAKING state
-                    speechStartTime = now;
+                uint64_t now = streamPosition.load();
+                if (now - speechStartSample >= static_cast<uint64_t>(maxSpeechSamples)) {
+                    // Force processing of the current chunk if it's too long; remain in SPEAKING state
+                    splitLongSpeechChunk();
                 }
             }
             break;
@@ -287,74 +571,282 @@ void AudioManager::updateSpeechState(float soundLevel) {
     }
 }
 
+// Start a speech chunk with the pre-speech audio (consumed straight from the ring)
+void AudioManager::beginSpeechChunk() {
+    CircularBuffer<float>::View preRoll = preSpeechBuffer.view();
+    
+    currentSpeechBuffer.clear();
+    currentSpeechBuffer.reserve(preRoll.size() + static_cast<size_t>(sampleRate) * 2);
+    currentSpeechBuffer.insert(currentSpeechBuffer.end(), preRoll.first, preRoll.first + preRoll.firstSize);
+    currentSpeechBuffer.insert(currentSpeechBuffer.end(), preRoll.second, preRoll.second + preRoll.secondSize);
+    
+    // The chunk's spectrogram starts with the pre-roll too
+    if (incrementalMel) {
+        chunkMel.reset();
+        chunkMel.push(preRoll.first, preRoll.firstSize);
+        chunkMel.push(preRoll.second, preRoll.secondSize);
+    }
+    
+    // The pre-roll now belongs to this chunk; a max-length split must not repeat it
+    preSpeechBuffer.clear();
+}
+
 // Process a completed speech chunk
 void AudioManager::processSpeechBasedChunk() {
     if (currentSpeechBuffer.empty()) {
         return;
     }
+    TRACE_SCOPE("AudioManager::processSpeechBasedChunk");
     
-    std::lock_guard<std::mutex> lock(continuousMutex);
+    // The chunk already starts with its pre-speech audio, so hand it over without copying;
+    // its spectrogram only needs the trailing frames and normalization
+    AudioChunk chunk;
+    chunk.samples = std::move(currentSpeechBuffer);
+    chunk.timing = closeTiming(speechStartSample, lastSpeechSample);
+    if (incrementalMel) {
+        // A chunk trimmed at a split point no longer matches its spectrogram
+        if (chunkMel.sampleCount() == chunk.samples.size()) {
+            chunk.mel = chunkMel.finish();
+        } else {
+            chunkMel.reset();
+        }
+    }
+    currentSpeechBuffer = std::vector<float>();
+    enqueueChunk(std::move(chunk));
+}
+
+// Middle of the quietest 20 ms frame in the last searchSamples of the buffer; the end
+// of the buffer if it is too short to search
+size_t AudioManager::findSplitPoint(const std::vector<float>& buffer, size_t searchSamples) const {
+    const size_t frameSize = static_cast<size_t>(sampleRate) / 50;
+    size_t begin = buffer.size() - std::min(searchSamples, buffer.size());
+    if (buffer.size() - begin < frameSize) {
+        return buffer.size();
+    }
+    return findQuietestFrame(buffer.data(), begin, buffer.size(), frameSize) + frameSize / 2;
+}
+
+// The speech chunk reached maxSpeechSamples: queue it up to the quietest point of its
+// last splitSearchSamples and start the next chunk there, repeating only
+// splitOverlapSamples before the cut
+void AudioManager::splitLongSpeechChunk() {
+    uint64_t now = streamPosition.load();
+    size_t size = currentSpeechBuffer.size();
+    size_t cut = findSplitPoint(currentSpeechBuffer, splitSearchSamples);
+    size_t carryStart = cut - std::min(cut, splitOverlapSamples);
+    std::vector<float> carry(currentSpeechBuffer.begin() + carryStart, currentSpeechBuffer.end());
+    Logger::info("Max speech duration reached - splitting chunk " +
+                 std::to_string((size - cut) * 1000 / sampleRate) + " ms before the limit");
     
-    // Create a complete chunk that includes the pre-speech buffer
-    std::vector<float> completeChunk;
+    currentSpeechBuffer.resize(cut);
+    lastSpeechSample = now - (size - cut);
+    processSpeechBasedChunk();
     
-    // Add pre-speech buffer first (contains audio right before speech was detected)
-    if (!preSpeechBuffer.empty()) {
-        completeChunk.reserve(preSpeechBuffer.size() + currentSpeechBuffer.size());
-        completeChunk.insert(completeChunk.end(), preSpeechBuffer.begin(), preSpeechBuffer.end());
-    } else {
-        completeChunk.reserve(currentSpeechBuffer.size());
+    // The next chunk starts with the audio after the cut (plus the overlap)
+    currentSpeechBuffer = std::move(carry);
+    if (incrementalMel) {
+        chunkMel.reset();
+        chunkMel.push(currentSpeechBuffer.data(), currentSpeechBuffer.size());
     }
+    speechStartSample = now - currentSpeechBuffer.size();
+    lastSpeechSample = now;
+}
+
+ChunkTiming AudioManager::closeTiming(uint64_t startSample, uint64_t speechEndSample) const {
+    ChunkTiming timing;
+    timing.endpointSample = streamPosition.load();
+    timing.speechStartSample = std::min(startSample, timing.endpointSample);
+    timing.speechEndSample = std::min(std::max(speechEndSample, timing.speechStartSample), timing.endpointSample);
+    timing.endpoint = ChunkTiming::Clock::now();
+    return timing;
+}
+
+void AudioManager::enqueueChunk(AudioChunk chunk) {
+    std::lock_guard<std::mutex> lock(continuousMutex);
+    queuedSamples.fetch_add(chunk.samples.size());
+    continuousChunks.push_back(std::move(chunk));
     
-    // Add the actual speech buffer
-    completeChunk.insert(completeChunk.end(), currentSpeechBuffer.begin(), currentSpeechBuffer.end());
-    
-    // Copy the complete chunk to the continuous chunks queue
-    continuousChunks.push_back(std::move(completeChunk));
+    // Live capture can't wait, so an overflowing queue is trimmed instead
+    if (source->isRealtime() && maxQueuedSamples > 0 && queuedSamples.load() > maxQueuedSamples) {
+        applyQueuePolicy();
+    }
     
-    // Clear the current speech buffer but keep the pre-speech buffer
-    currentSpeechBuffer.clear();
+    queueStats.peakDepth = std::max(queueStats.peakDepth, continuousChunks.size());
+    queueStats.peakQueuedSeconds = std::max(queueStats.peakQueuedSeconds,
+                                            static_cast<double>(queuedSamples.load()) / sampleRate);
+    updateQueueHealth();
     
     // Set flag indicating new continuous audio is available
     newContinuousAudioAvailable.store(true);
 }
 
+// Bring an over-limit queue back in line (continuousMutex is held)
+void AudioManager::applyQueuePolicy() {
+    switch (queuePolicy) {
+        case QueuePolicy::MERGE:
+            // Fewer, longer chunks pay the per-decode overhead once. Fixed-size chunks
+            // overlap each other, so only speech chunks can simply be joined.
+            if (speechDetectionEnabled && settings.speechDetection.enabled) {
+                for (size_t i = 0; i + 1 < continuousChunks.size();) {
+                    AudioChunk& first = continuousChunks[i];
+                    AudioChunk& second = continuousChunks[i + 1];
+                    if (first.samples.size() + second.samples.size() > maxMergedSamples) {
+                        i++;
+                        continue;
+                    }
+                    // The merged chunk keeps the first's capture time and the second's endpoint
+                    first.samples.insert(first.samples.end(), second.samples.begin(), second.samples.end());
+                    first.mel = MelFrames();
+                    first.timing.speechEndSample = second.timing.speechEndSample;
+                    first.timing.endpointSample = second.timing.endpointSample;
+                    first.preferFast = first.preferFast || second.preferFast;
+                    continuousChunks.erase(continuousChunks.begin() + i + 1);
+                    queueStats.mergedChunks++;
+                }
+            }
+            break;
+        case QueuePolicy::FAST_MODEL:
+            for (AudioChunk& chunk : continuousChunks) {
+                if (!chunk.preferFast) {
+                    chunk.preferFast = true;
+                    queueStats.downgradedChunks++;
+                }
+            }
+            break;
+        case QueuePolicy::DROP_OLDEST:
+            while (continuousChunks.size() > 1 && queuedSamples.load() > maxQueuedSamples) {
+                dropOldestChunk();
+            }
+            break;
+        case QueuePolicy::NONE:
+            return;
+    }
+    
+    // Merging and downgrading only slow the growth; past twice the limit, stale speech goes
+    while (continuousChunks.size() > 1 && queuedSamples.load() > 2 * maxQueuedSamples) {
+        dropOldestChunk();
+    }
+}
+
+// continuousMutex is held
+void AudioManager::dropOldestChunk() {
+    size_t samples = continuousChunks.front().samples.size();
+    continuousChunks.pop_front();
+    queuedSamples.fetch_sub(samples);
+    queueStats.droppedChunks++;
+    queueStats.droppedSeconds += static_cast<double>(samples) / sampleRate;
+    Logger::error("Chunk queue over " + std::to_string(maxQueuedSamples / sampleRate) + " s: dropped " +
+                  std::to_string(static_cast<double>(samples) / sampleRate).substr(0, 4) + " s of stale speech");
+}
+
+// Log once when transcription stops keeping up and once when it recovers (continuousMutex is held)
+void AudioManager::updateQueueHealth() {
+    double oldestAgeMs = 0.0;
+    if (!continuousChunks.empty() && ChunkTiming::isSet(continuousChunks.front().timing.endpoint)) {
+        oldestAgeMs = std::chrono::duration<double, std::milli>(
+            ChunkTiming::Clock::now() - continuousChunks.front().timing.endpoint).count();
+    }
+    bool behind = (maxQueuedSamples > 0 && queuedSamples.load() > maxQueuedSamples) ||
+                  (warnAgeMs > 0.0 && oldestAgeMs > warnAgeMs);
+    if (behind == queueStats.fallingBehind) {
+        return;
+    }
+    
+    queueStats.fallingBehind = behind;
+    double queuedSeconds = static_cast<double>(queuedSamples.load()) / sampleRate;
+    if (behind) {
+        Logger::error("Transcription is falling behind real time: " + std::to_string(continuousChunks.size()) +
+                      " chunk(s), " + std::to_string(queuedSeconds).substr(0, 5) + " s queued, oldest " +
+                      std::to_string(static_cast<int>(oldestAgeMs)) + " ms old");
+    } else {
+        Logger::info("Transcription caught up: " + std::to_string(continuousChunks.size()) + " chunk(s), " +
+                     std::to_string(queuedSeconds).substr(0, 5) + " s queued");
+    }
+}
+
+bool AudioManager::isBackpressured() const {
+    return source && !source->isRealtime() && maxQueuedSamples > 0 && recording.load() &&
+           continuousMode.load() && !flushRequested.load() && queuedSamples.load() >= maxQueuedSamples;
+}
+
+ChunkQueueStats AudioManager::getChunkQueueStats() const {
+    std::lock_guard<std::mutex> lock(continuousMutex);
+    ChunkQueueStats stats = queueStats;
+    stats.depth = continuousChunks.size();
+    stats.queuedSeconds = static_cast<double>(queuedSamples.load()) / sampleRate;
+    if (!continuousChunks.empty() && ChunkTiming::isSet(continuousChunks.front().timing.endpoint)) {
+        stats.oldestAgeMs = std::chrono::duration<double, std::milli>(
+            ChunkTiming::Clock::now() - continuousChunks.front().timing.endpoint).count();
+    }
+    return stats;
+}
+
 // Get current speech state
 SpeechState AudioManager::getSpeechState() const {
     return currentSpeechState.load();
 }
 
-// Process incoming audio data
-void AudioManager::processAudioData(const Uint8* stream, int len) {
-    if (!recording.load()) return;
+// Process a block of audio on the processing thread (audioMutex is held)
+void AudioManager::processAudioData(const float* floatStream, int numSamples) {
+    if (numSamples <= 0) return;
+    TRACE_SCOPE("AudioManager::processAudioData");
     
-    // Convert Uint8 stream to float for processing
-    const float* floatStream = reinterpret_cast<const float*>(stream);
-    int numSamples = len / sizeof(float);
+    // Advance the stream clock before any state update looks at it
+    streamPosition.fetch_add(numSamples);
     
-    // Calculate the current audio level (RMS)
-    float rms = calculateRMS(floatStream, numSamples);
+    // Calculate level, peak and zero-crossing rate in one pass
+    AudioBlockStats stats = computeBlockStats(floatStream, numSamples);
+    float rms = stats.rms();
     currentAudioLevel.store(rms);
+    currentPeakLevel.store(stats.peak);
+    currentZeroCrossingRate.store(stats.zeroCrossingRate());
     
     // Log the audio level occasionally
     static int logCounter = 0;
     if (++logCounter % 100 == 0) {
-        Logger::info("RMS Sound Level: " + std::to_string(rms));
+        std::string levels = "RMS Sound Level: " + std::to_string(rms) +
+                             ", peak " + std::to_string(stats.peak) +
+                             ", ZCR " + std::to_string(stats.zeroCrossingRate());
+        if (continuousMode.load()) {
+            Logger::info(levels);
+        } else {
+            Logger::info(levels +
+                         ", capture buffer " + std::to_string(audioBuffer.bufferedBytes() / 1024) + " KB" +
+                         " (peak " + std::to_string(audioBuffer.peakBytes() / 1024) + " KB)");
+        }
     }
     
-    // Add audio data to the buffer
-    std::lock_guard<std::mutex> lock(audioMutex);
-    size_t startPos = audioBuffer.size();
-    audioBuffer.resize(startPos + numSamples);
-    memcpy(audioBuffer.data() + startPos, floatStream, len);
-    
     // Check for silence in regular mode
     if (!continuousMode.load()) {
-        // Increment silence counter if below threshold
+        // Only push-to-talk recordings are kept whole; continuous mode uses the chunk queue
+        audioBuffer.append(floatStream, numSamples);
+        
+        // The spectrogram shares the capture memory budget with the samples; once the
+        // two would outgrow it (or the recording spills), whisper works from the PCM
+        if (recordingMelActive) {
+            recordingMel.push(floatStream, numSamples);
+            if (audioBuffer.isSpilled() ||
+                audioBuffer.bufferedBytes() + recordingMel.finishedBytes() > captureBudgetBytes) {
+                Logger::info("Recording spectrogram stopped at " +
+                             std::to_string(static_cast<double>(recordingMel.sampleCount()) / sampleRate).substr(0, 5) +
+                             " s to stay within capture.max_memory_mb");
+                recordingMel.release();
+                recordingMelActive = false;
+            }
+        }
+        
+        // Accumulate silent samples if below threshold
         if (rms < silenceThreshold) {
-            silenceCounter++;
+            silenceSampleCount += numSamples;
         } else {
-            silenceCounter = 0;
+            silenceSampleCount = 0;
+            segmentClosedInPause = false;
+        }
+        
+        // A pause ends a sentence that can be decoded while recording goes on
+        if (segmentPipelining && recording.load() && !segmentClosedInPause &&
+            silenceSampleCount >= segmentPauseSamples) {
+            closeRecordingSegment();
         }
     }
     // Handle continuous mode
@@ -364,24 +856,19 @@ void AudioManager::processAudioData(const Uint8* stream, int len) {
             
             // First, update the pre-speech buffer
             if (currentSpeechState.load() == SpeechState::SILENCE) {
-                // In silence mode, maintain the pre-speech buffer
-                preSpeechBuffer.insert(preSpeechBuffer.end(), floatStream, floatStream + numSamples);
-                
-                // Keep only the most recent samples based on buffer size
-                if (preSpeechBuffer.size() > preSpeechBufferSize) {
-                    preSpeechBuffer.erase(
-                        preSpeechBuffer.begin(),
-                        preSpeechBuffer.begin() + (preSpeechBuffer.size() - preSpeechBufferSize)
-                    );
-                }
+                // In silence mode, maintain the pre-speech ring (oldest samples are overwritten)
+                preSpeechBuffer.push(floatStream, numSamples);
             }
             else if (currentSpeechState.load() == SpeechState::SPEAKING) {
                 // In speaking mode, add samples to the current speech buffer
                 currentSpeechBuffer.insert(currentSpeechBuffer.end(), floatStream, floatStream + numSamples);
+                if (incrementalMel) {
+                    chunkMel.push(floatStream, numSamples);
+                }
             }
             
             // Update the speech state
-            updateSpeechState(rms);
+            updateSpeechState(stats);
         }
         else {
             // Traditional fixed-chunk continuous mode (fallback)
@@ -389,46 +876,35 @@ void AudioManager::processAudioData(const Uint8* stream, int len) {
             
             // Check if we have enough data for continuous processing
             if (continuousBuffer.size() >= continuousSampleThreshold) {
-                std::lock_guard<std::mutex> continuousLock(continuousMutex);
+                // End the chunk at a quiet point in its second half, so no word is cut in two
+                size_t cut = findSplitPoint(continuousBuffer, std::min(splitSearchSamples, continuousBuffer.size() / 2));
+                size_t carryStart = cut - std::min(cut, splitOverlapSamples);
                 
                 // Copy current chunk to the continuous chunks queue
-                continuousChunks.push_back(continuousBuffer);
-                
-                // Keep 1 second of audio for overlap
-                int overlapSamples = sampleRate * 1.0; // 1 second overlap
-                
-                // Create a new continuous buffer with overlap
-                std::vector<float> newBuffer;
-                if (continuousBuffer.size() > overlapSamples) {
-                    newBuffer.assign(
-                        continuousBuffer.end() - overlapSamples,
-                        continuousBuffer.end()
-                    );
-                }
-                
-                // Replace the continuous buffer with the overlapped portion
-                continuousBuffer = std::move(newBuffer);
+                uint64_t end = streamPosition.load();
+                AudioChunk chunk;
+                chunk.samples.assign(continuousBuffer.begin(), continuousBuffer.begin() + cut);
+                chunk.timing = closeTiming(end - continuousBuffer.size(), end - (continuousBuffer.size() - cut));
+                enqueueChunk(std::move(chunk));
                 
-                // Set flag indicating new continuous audio is available
-                newContinuousAudioAvailable.store(true);
+                // Start the next chunk at the cut, with a short overlap for the text merge
+                continuousBuffer.erase(continuousBuffer.begin(), continuousBuffer.begin() + carryStart);
             }
         }
     }
 }
 
-// Calculate RMS value for audio level
-float AudioManager::calculateRMS(const float* samples, int sampleCount) {
-    if (sampleCount <= 0) return 0.0f;
-    
-    float sum = 0.0f;
-    for (int i = 0; i < sampleCount; i++) {
-        sum += samples[i] * samples[i];
-    }
-    
-    return std::sqrt(sum / sampleCount);
-}
-
 // Get the current audio level
 float AudioManager::getCurrentAudioLevel() const {
     return currentAudioLevel.load();
 }
+
+// Get the peak level of the latest block
+float AudioManager::getCurrentPeakLevel() const {
+    return currentPeakLevel.load();
+}
+
+// Get the zero-crossing rate of the latest block
+float AudioManager::getCurrentZeroCrossingRate() const {
+    return currentZeroCrossingRate.load();
+}
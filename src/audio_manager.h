@@ -1,12 +1,21 @@
 #pragma once
 
 #include "settings.h"
-#include <SDL2/SDL.h>
+#include "ring_buffer.h"
+#include "circular_buffer.h"
+#include "capture_store.h"
+#include "audio_stats.h"
+#include "audio_source.h"
+#include "audio_chunk.h"
+#include "mel_spectrogram.h"
 #include <vector>
 #include <deque>
 #include <mutex>
 #include <atomic>
 #include <chrono>
+#include <thread>
+#include <cstdint>
+#include <memory>
 
 // Speech detection states
 enum class SpeechState {
@@ -15,80 +24,207 @@ enum class SpeechState {
     TRANSITION   // Transitioning between states
 };
 
-class AudioManager {
+// Capture pipeline counters; capturedSamples == processedSamples + droppedSamples
+// (plus whatever is still in the ring) proves no audio went missing silently
+struct CaptureStats {
+    uint64_t capturedSamples = 0;   // Samples delivered by the audio source
+    uint64_t processedSamples = 0;  // Samples handled by the processing thread
+    uint64_t droppedSamples = 0;    // Samples lost because the ring was full
+    uint64_t overruns = 0;          // Callbacks that could not be stored completely
+    size_t ringCapacity = 0;        // Ring size in samples
+    size_t ringHighWater = 0;       // Highest ring fill level seen by the consumer
+};
+
+// Continuous-mode chunks waiting to be transcribed
+struct ChunkQueueStats {
+    size_t depth = 0;                // Chunks waiting
+    double queuedSeconds = 0.0;      // Audio waiting
+    double oldestAgeMs = 0.0;        // Since the oldest waiting chunk was closed
+    size_t peakDepth = 0;
+    double peakQueuedSeconds = 0.0;
+    uint64_t droppedChunks = 0;      // Stale chunks discarded by the overflow policy
+    double droppedSeconds = 0.0;
+    uint64_t mergedChunks = 0;       // Chunks folded into their neighbour
+    uint64_t downgradedChunks = 0;   // Chunks flagged for the fast model
+    bool fallingBehind = false;      // Over the queue limit or the age warning
+};
+
+class AudioManager : public AudioSink {
 public:
     AudioManager(Settings& settings);
     ~AudioManager();
     
-    bool init();
+    // Open the given source (device, file or pipe) and start the processing thread
+    bool init(std::unique_ptr<AudioSource> source);
     void startRecording();
     void stopRecording();
     bool isRecording() const;
     std::vector<float> getAudioData() const;
     
+    // Push-to-talk recording with the spectrogram computed while it was captured.
+    // Once segments have been taken, only the audio after the last one is returned.
+    AudioChunk getRecording();
+    
+    // Finished sentences of the push-to-talk recording in progress, ended by a pause;
+    // take them in order while recording to decode them before the user stops
+    bool hasRecordingSegment() const;
+    AudioChunk takeRecordingSegment();
+    
     // Continuous mode methods
     void setContinuousMode(bool enabled);
     bool isContinuousMode() const;
     bool hasNewContinuousAudio();
-    std::vector<float> getContinuousAudioChunk();
+    AudioChunk getContinuousAudioChunk();
     void resetContinuousFlag();
     
+    // Command mode (mouse mode) ends speech chunks after a shorter silence
+    void setCommandMode(bool enabled);
+    
     // Silence detection
     bool checkSilence();
     
     // Get current audio level (for UI visualization)
     float getCurrentAudioLevel() const;
     
+    // Get peak level and zero-crossing rate of the latest block
+    float getCurrentPeakLevel() const;
+    float getCurrentZeroCrossingRate() const;
+    
     // Get current speech state
     SpeechState getSpeechState() const;
+    
+    // Get capture ring buffer counters
+    CaptureStats getCaptureStats() const;
+    
+    // Depth, age and overflow counters of the continuous chunk queue
+    ChunkQueueStats getChunkQueueStats() const;
+    
+    // Samples processed since the source was opened; the clock for all VAD timing
+    uint64_t getStreamPosition() const;
+    
+    // True once a file/pipe source has ended and its last chunk was queued
+    bool isEndOfStream() const;
+    
+    // AudioSink interface, called from the source's thread
+    void pushRealtime(const float* samples, size_t count) override;
+    size_t pushBlocking(const float* samples, size_t count) override;
+    void endOfStream() override;
 
 private:
-    static void audioCallback(void* userdata, Uint8* stream, int len);
-    void processAudioData(const Uint8* stream, int len);
-    float calculateRMS(const float* samples, int sampleCount);
+    void processingLoop();
+    void finishStream();
+    void waitForDrain();
+    void processAudioData(const float* samples, int numSamples);
     
     // Speech detection for continuous mode
-    bool detectSpeech(float soundLevel);
-    void updateSpeechState(float soundLevel);
+    bool detectSpeech(const AudioBlockStats& stats);
+    void updateSpeechState(const AudioBlockStats& stats);
+    void beginSpeechChunk();
     void processSpeechBasedChunk();
     
-    // Audio device and buffers
-    SDL_AudioDeviceID deviceId = 0;
-    std::vector<float> audioBuffer;
+    // End a chunk that reached its length limit at a quiet point instead of mid-word
+    size_t findSplitPoint(const std::vector<float>& buffer, size_t searchSamples) const;
+    void splitLongSpeechChunk();
+    
+    // Close a push-to-talk segment in the middle of the current pause
+    void closeRecordingSegment();
+    
+    // Capture-side timestamps for a chunk that ends at the current stream position
+    ChunkTiming closeTiming(uint64_t startSample, uint64_t speechEndSample) const;
+    
+    // Queue a finished continuous chunk, applying the overflow policy
+    void enqueueChunk(AudioChunk chunk);
+    void applyQueuePolicy();
+    void dropOldestChunk();
+    void updateQueueHealth();
+    bool isBackpressured() const;
+    
+    // Audio source and buffers
+    std::unique_ptr<AudioSource> source;
+    CaptureStore audioBuffer;  // Push-to-talk recording, bounded by settings.capture
+    
+    // Spectrograms built as samples arrive, so only the model runs after end of speech
+    bool incrementalMel = false;
+    bool recordingMelActive = false;  // Cleared when the recording's spectrogram outgrows the budget
+    size_t captureBudgetBytes = 0;
+    MelSpectrogram recordingMel;
+    MelSpectrogram chunkMel;
     std::vector<float> continuousBuffer;
     std::atomic<bool> recording{false};
-    std::mutex audioMutex;
+    mutable std::mutex audioMutex;
+    
+    // Lock-free hand-off from the audio source to the processing thread
+    SpscRingBuffer<float> ringBuffer;
+    std::thread processingThread;
+    std::atomic<bool> processingActive{false};
+    std::atomic<bool> flushRequested{false};
+    int blockSize = 1024;
+    std::atomic<uint64_t> capturedSamples{0};
+    std::atomic<uint64_t> processedSamples{0};
+    std::atomic<uint64_t> droppedSamples{0};
+    std::atomic<uint64_t> overrunCount{0};
+    std::atomic<size_t> ringHighWater{0};
+    
+    // Sample-count clock and end-of-stream state for file/pipe sources
+    std::atomic<uint64_t> streamPosition{0};
+    std::atomic<bool> endOfStreamPending{false};
+    std::atomic<bool> streamEnded{false};
     
     // Continuous mode support
     std::atomic<bool> continuousMode{false};
     std::atomic<bool> newContinuousAudioAvailable{false};
     std::atomic<bool> newContinuousAudioReady{false};
-    std::deque<std::vector<float>> continuousChunks;
+    std::deque<AudioChunk> continuousChunks;
     mutable std::mutex continuousMutex;
+    
+    // Chunk queue limits; live capture applies the policy, files and pipes are held back
+    enum class QueuePolicy { NONE, MERGE, DROP_OLDEST, FAST_MODEL };
+    QueuePolicy queuePolicy = QueuePolicy::MERGE;
+    size_t maxQueuedSamples = 0;
+    size_t maxMergedSamples = 0;
+    double warnAgeMs = 0.0;
+    std::atomic<size_t> queuedSamples{0};
+    ChunkQueueStats queueStats;  // Counters and peaks; guarded by continuousMutex
     int continuousSampleThreshold;
-    std::chrono::steady_clock::time_point lastContinuousProcessTime;
     
-    // Silence detection
-    int silenceCounter = 0;
-    int silenceChunks = 0;
+    // Silence detection (push-to-talk), in samples
+    int silenceSampleCount = 0;
+    uint64_t recordingStartSample = 0;
+    
+    // Push-to-talk segments; offsets are into the recording, guarded by audioMutex
+    struct RecordingSegment {
+        size_t end = 0;
+        AudioChunk chunk;
+    };
+    std::deque<RecordingSegment> recordingSegments;
+    std::atomic<size_t> recordingSegmentCount{0};
+    bool segmentPipelining = false;
+    int segmentPauseSamples = 0;
+    size_t minSegmentSamples = 0;
+    size_t segmentStart = 0;        // Where the next segment begins
+    size_t takenSamples = 0;        // End of the last segment taken
+    bool segmentClosedInPause = false;
     
     // Speech detection variables
     std::atomic<SpeechState> currentSpeechState{SpeechState::SILENCE};
-    std::vector<float> preSpeechBuffer;
+    CircularBuffer<float> preSpeechBuffer;
     std::vector<float> currentSpeechBuffer;
-    int silenceFrameCount = 0;
-    int speechFrameCount = 0;
+    // Durations are counted in samples so timing follows the stream, not the wall clock
+    int silenceSamples = 0;
+    int speechSamples = 0;
     float speechThreshold = 0.02f;
-    int minSilenceFrames = 50;
-    int minSpeechFrames = 10;
-    int maxSpeechFrames = 0;
+    float maxSpeechZeroCrossingRate = 0.0f;
+    int minSilenceSamples = 0;
+    int commandMinSilenceSamples = 0;
+    std::atomic<bool> commandMode{false};
+    int minSpeechSamples = 0;
+    int maxSpeechSamples = 0;
+    size_t splitSearchSamples = 0;
+    size_t splitOverlapSamples = 0;
     int preSpeechBufferSize = 0;
     bool speechDetectionEnabled = true;
-    std::chrono::steady_clock::time_point speechStartTime;
-    
-    // Audio specs
-    SDL_AudioSpec desiredSpec;
-    SDL_AudioSpec obtainedSpec;
+    uint64_t speechStartSample = 0;
+    uint64_t lastSpeechSample = 0;
     
     // Settings
     Settings& settings;
@@ -98,4 +234,6 @@ private:
     
     // Current audio level
     std::atomic<float> currentAudioLevel{0.0f};
+    std::atomic<float> currentPeakLevel{0.0f};
+    std::atomic<float> currentZeroCrossingRate{0.0f};
 };
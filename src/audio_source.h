@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Receives mono float samples from an AudioSource (implemented by AudioManager)
+class AudioSink {
+public:
+    virtual ~AudioSink() = default;
+
+    // Real-time delivery from a device callback: never blocks, drops what doesn't fit
+    virtual void pushRealtime(const float* samples, size_t count) = 0;
+
+    // Paced delivery from a file or pipe: waits until the consumer has room.
+    // Returns how many samples were accepted (fewer than count if capture stopped).
+    virtual size_t pushBlocking(const float* samples, size_t count) = 0;
+
+    // The source has delivered its last sample
+    virtual void endOfStream() = 0;
+};
+
+// A producer of mono float audio at the application sample rate
+class AudioSource {
+public:
+    virtual ~AudioSource() = default;
+
+    // Prepare the source; samples are delivered to sink once started
+    virtual bool open(int sampleRate, AudioSink* sink) = 0;
+
+    // Begin / pause delivering samples
+    virtual void start() = 0;
+    virtual void stop() = 0;
+
+    // Release the source
+    virtual void close() = 0;
+
+    // Number of samples delivered per block
+    virtual int blockSize() const = 0;
+
+    // True if samples arrive at wall-clock rate, false if as fast as they are consumed
+    virtual bool isRealtime() const = 0;
+
+    // Human-readable description for logs
+    virtual std::string describe() const = 0;
+};
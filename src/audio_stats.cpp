@@ -0,0 +1,240 @@
+#include "audio_stats.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define AUDIO_STATS_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define AUDIO_STATS_NEON 1
+#include <arm_neon.h>
+#endif
+
+float AudioBlockStats::rms() const {
+    if (sampleCount <= 0) return 0.0f;
+    return static_cast<float>(std::sqrt(sumSquares / sampleCount));
+}
+
+float AudioBlockStats::zeroCrossingRate() const {
+    if (sampleCount <= 1) return 0.0f;
+    return static_cast<float>(zeroCrossings) / (sampleCount - 1);
+}
+
+// Scalar tail shared by all kernels: samples [start, count), with samples[start - 1]
+// as the previous sample for zero-crossing detection when start > 0
+static void accumulateScalar(const float* samples, size_t start, size_t count, AudioBlockStats& stats) {
+    for (size_t i = start; i < count; i++) {
+        double s = samples[i];
+        stats.sumSquares += s * s;
+
+        float magnitude = std::fabs(samples[i]);
+        if (magnitude > stats.peak) stats.peak = magnitude;
+
+        if (i > 0 && ((samples[i] < 0.0f) != (samples[i - 1] < 0.0f))) {
+            stats.zeroCrossings++;
+        }
+    }
+}
+
+AudioBlockStats computeBlockStatsScalar(const float* samples, size_t count) {
+    AudioBlockStats stats;
+    stats.sampleCount = static_cast<int>(count);
+    accumulateScalar(samples, 0, count, stats);
+    return stats;
+}
+
+#ifdef AUDIO_STATS_X86
+
+__attribute__((target("sse2")))
+static AudioBlockStats computeBlockStatsSse2(const float* samples, size_t count) {
+    AudioBlockStats stats;
+    stats.sampleCount = static_cast<int>(count);
+    if (count == 0) return stats;
+
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 zero = _mm_setzero_ps();
+    __m128d sumLo = _mm_setzero_pd();
+    __m128d sumHi = _mm_setzero_pd();
+    __m128 peak = _mm_setzero_ps();
+    int crossings = 0;
+
+    // Sample 0 has no predecessor, so it goes through the scalar path
+    accumulateScalar(samples, 0, 1, stats);
+
+    // Vector loop compares each lane with the sample before it (unaligned load at i - 1)
+    size_t i = 1;
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_loadu_ps(samples + i);
+        __m128 prev = _mm_loadu_ps(samples + i - 1);
+
+        __m128d lo = _mm_cvtps_pd(v);
+        __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+        sumLo = _mm_add_pd(sumLo, _mm_mul_pd(lo, lo));
+        sumHi = _mm_add_pd(sumHi, _mm_mul_pd(hi, hi));
+
+        peak = _mm_max_ps(peak, _mm_and_ps(v, absMask));
+
+        __m128 signChange = _mm_xor_ps(_mm_cmplt_ps(v, zero), _mm_cmplt_ps(prev, zero));
+        crossings += __builtin_popcount(_mm_movemask_ps(signChange));
+    }
+
+    double sums[2];
+    _mm_storeu_pd(sums, _mm_add_pd(sumLo, sumHi));
+    stats.sumSquares += sums[0] + sums[1];
+
+    float peaks[4];
+    _mm_storeu_ps(peaks, peak);
+    for (float p : peaks) {
+        if (p > stats.peak) stats.peak = p;
+    }
+    stats.zeroCrossings += crossings;
+
+    accumulateScalar(samples, i, count, stats);
+    return stats;
+}
+
+__attribute__((target("avx2")))
+static AudioBlockStats computeBlockStatsAvx2(const float* samples, size_t count) {
+    AudioBlockStats stats;
+    stats.sampleCount = static_cast<int>(count);
+    if (count == 0) return stats;
+
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 zero = _mm256_setzero_ps();
+    __m256d sumLo = _mm256_setzero_pd();
+    __m256d sumHi = _mm256_setzero_pd();
+    __m256 peak = _mm256_setzero_ps();
+    int crossings = 0;
+
+    accumulateScalar(samples, 0, 1, stats);
+
+    size_t i = 1;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(samples + i);
+        __m256 prev = _mm256_loadu_ps(samples + i - 1);
+
+        __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+        __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+        sumLo = _mm256_add_pd(sumLo, _mm256_mul_pd(lo, lo));
+        sumHi = _mm256_add_pd(sumHi, _mm256_mul_pd(hi, hi));
+
+        peak = _mm256_max_ps(peak, _mm256_and_ps(v, absMask));
+
+        __m256 signChange = _mm256_xor_ps(_mm256_cmp_ps(v, zero, _CMP_LT_OQ),
+                                          _mm256_cmp_ps(prev, zero, _CMP_LT_OQ));
+        crossings += __builtin_popcount(_mm256_movemask_ps(signChange));
+    }
+
+    double sums[4];
+    _mm256_storeu_pd(sums, _mm256_add_pd(sumLo, sumHi));
+    stats.sumSquares += sums[0] + sums[1] + sums[2] + sums[3];
+
+    float peaks[8];
+    _mm256_storeu_ps(peaks, peak);
+    for (float p : peaks) {
+        if (p > stats.peak) stats.peak = p;
+    }
+    stats.zeroCrossings += crossings;
+
+    accumulateScalar(samples, i, count, stats);
+    return stats;
+}
+
+#endif // AUDIO_STATS_X86
+
+#ifdef AUDIO_STATS_NEON
+
+static AudioBlockStats computeBlockStatsNeon(const float* samples, size_t count) {
+    AudioBlockStats stats;
+    stats.sampleCount = static_cast<int>(count);
+    if (count == 0) return stats;
+
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    float64x2_t sumLo = vdupq_n_f64(0.0);
+    float64x2_t sumHi = vdupq_n_f64(0.0);
+    float32x4_t peak = vdupq_n_f32(0.0f);
+    uint32x4_t crossings = vdupq_n_u32(0);
+
+    accumulateScalar(samples, 0, 1, stats);
+
+    size_t i = 1;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t v = vld1q_f32(samples + i);
+        float32x4_t prev = vld1q_f32(samples + i - 1);
+
+        float64x2_t lo = vcvt_f64_f32(vget_low_f32(v));
+        float64x2_t hi = vcvt_high_f64_f32(v);
+        sumLo = vfmaq_f64(sumLo, lo, lo);
+        sumHi = vfmaq_f64(sumHi, hi, hi);
+
+        peak = vmaxq_f32(peak, vabsq_f32(v));
+
+        // Comparison lanes are all-ones when true; shift down to count them
+        uint32x4_t signChange = veorq_u32(vcltq_f32(v, zero), vcltq_f32(prev, zero));
+        crossings = vaddq_u32(crossings, vshrq_n_u32(signChange, 31));
+    }
+
+    stats.sumSquares += vaddvq_f64(vaddq_f64(sumLo, sumHi));
+    float vectorPeak = vmaxvq_f32(peak);
+    if (vectorPeak > stats.peak) stats.peak = vectorPeak;
+    stats.zeroCrossings += static_cast<int>(vaddvq_u32(crossings));
+
+    accumulateScalar(samples, i, count, stats);
+    return stats;
+}
+
+#endif // AUDIO_STATS_NEON
+
+typedef AudioBlockStats (*BlockStatsKernel)(const float*, size_t);
+
+struct KernelChoice {
+    BlockStatsKernel kernel;
+    const char* name;
+};
+
+// Pick the best kernel once, based on what the CPU reports at runtime
+static KernelChoice selectKernel() {
+#ifdef AUDIO_STATS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {computeBlockStatsAvx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return {computeBlockStatsSse2, "sse2"};
+    }
+#endif
+#ifdef AUDIO_STATS_NEON
+    return {computeBlockStatsNeon, "neon"};
+#endif
+    return {computeBlockStatsScalar, "scalar"};
+}
+
+static const KernelChoice& activeKernel() {
+    static const KernelChoice choice = selectKernel();
+    return choice;
+}
+
+AudioBlockStats computeBlockStats(const float* samples, size_t count) {
+    return activeKernel().kernel(samples, count);
+}
+
+const char* blockStatsKernelName() {
+    return activeKernel().name;
+}
+
+size_t findQuietestFrame(const float* samples, size_t begin, size_t end, size_t frameSize) {
+    if (!samples || frameSize == 0 || end < begin || end - begin < frameSize) {
+        return begin;
+    }
+    const size_t step = std::max<size_t>(1, frameSize / 2);
+    size_t best = begin;
+    double bestEnergy = -1.0;
+    for (size_t offset = begin; offset + frameSize <= end; offset += step) {
+        double energy = computeBlockStats(samples + offset, frameSize).sumSquares;
+        if (bestEnergy < 0.0 || energy <= bestEnergy) {
+            bestEnergy = energy;
+            best = offset;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+// Features of one block of audio, gathered in a single pass
+struct AudioBlockStats {
+    double sumSquares = 0.0;   // Sum of squared samples (double-width accumulation)
+    float peak = 0.0f;         // Largest absolute sample value
+    int zeroCrossings = 0;     // Sign changes between consecutive samples
+    int sampleCount = 0;
+
+    float rms() const;
+    float zeroCrossingRate() const;
+};
+
+// Compute block statistics with the fastest kernel available on this CPU
+AudioBlockStats computeBlockStats(const float* samples, size_t count);
+
+// Portable reference implementation (also the fallback kernel)
+AudioBlockStats computeBlockStatsScalar(const float* samples, size_t count);
+
+// Start of the quietest frameSize-sample frame that fits in [begin, end), searched in
+// half-frame steps; ties go to the later frame. Returns begin if no whole frame fits.
+size_t findQuietestFrame(const float* samples, size_t begin, size_t end, size_t frameSize);
+
+// Name of the kernel selected at runtime: "avx2", "sse2", "neon" or "scalar"
+const char* blockStatsKernelName();
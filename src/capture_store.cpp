@@ -0,0 +1,280 @@
+#include "capture_store.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdlib>
+#endif
+
+// Spill file grows in steps of this many samples (~1 minute at 16 kHz)
+static const size_t SPILL_GROW_SAMPLES = 16000 * 60;
+
+CaptureStore::CaptureStore() {}
+
+CaptureStore::~CaptureStore() {
+    releaseMapping();
+}
+
+void CaptureStore::configure(size_t maxMemory, bool enableSpill, size_t maxSpill, const std::string& dir) {
+    clear();
+    maxMemorySamples = maxMemory;
+    spillEnabled = enableSpill;
+    maxSpillSamples = maxSpill;
+    spillDir = dir;
+}
+
+void CaptureStore::clear() {
+    // Give the memory back instead of keeping the previous recording's capacity
+    std::vector<float>().swap(memory);
+    releaseMapping();
+    dropped = 0;
+    limitWarningLogged = false;
+    spillFailed = false;
+}
+
+size_t CaptureStore::append(const float* samples, size_t count) {
+    if (count == 0) return 0;
+
+    if (!spilled) {
+        size_t needed = memory.size() + count;
+
+        // Switch to the spill file once the memory budget would be exceeded
+        if (needed > maxMemorySamples && spillEnabled && !spillFailed) {
+            if (startSpill()) {
+                return append(samples, count);
+            }
+            // Don't retry on every block of this recording; keep within the memory budget instead
+            spillFailed = true;
+        }
+
+        size_t toStore = std::min(count, maxMemorySamples - std::min(maxMemorySamples, memory.size()));
+        if (toStore > 0) {
+            // Grow geometrically but never past the budget
+            if (memory.size() + toStore > memory.capacity()) {
+                size_t newCapacity = std::max(memory.size() + toStore, memory.capacity() * 2);
+                memory.reserve(std::min(newCapacity, maxMemorySamples));
+            }
+            memory.insert(memory.end(), samples, samples + toStore);
+        }
+
+        if (toStore < count) {
+            dropped += count - toStore;
+            if (!limitWarningLogged) {
+                Logger::error("Capture memory budget reached (" + std::to_string(maxMemorySamples * sizeof(float) / 1024) +
+                              " KB), dropping further audio");
+                limitWarningLogged = true;
+            }
+        }
+
+        peak = std::max(peak, bufferedBytes());
+        return toStore;
+    }
+
+    size_t toStore = std::min(count, maxSpillSamples - std::min(maxSpillSamples, mappedSize));
+    if (toStore > 0 && mappedSize + toStore > mappedCapacity) {
+        if (!growMapping(mappedSize + toStore)) {
+            toStore = mappedCapacity - mappedSize;
+        }
+    }
+    if (toStore > 0) {
+        std::memcpy(mapped + mappedSize, samples, toStore * sizeof(float));
+        mappedSize += toStore;
+    }
+
+    if (toStore < count) {
+        dropped += count - toStore;
+        if (!limitWarningLogged) {
+            Logger::error("Capture spill limit reached (" + std::to_string(maxSpillSamples * sizeof(float) / 1024) +
+                          " KB), dropping further audio");
+            limitWarningLogged = true;
+        }
+    }
+
+    peak = std::max(peak, bufferedBytes());
+    return toStore;
+}
+
+size_t CaptureStore::size() const {
+    return spilled ? mappedSize : memory.size();
+}
+
+bool CaptureStore::empty() const {
+    return size() == 0;
+}
+
+std::vector<float> CaptureStore::data() const {
+    if (!spilled) {
+        return memory;
+    }
+    return std::vector<float>(mapped, mapped + mappedSize);
+}
+
+void CaptureStore::copyRange(size_t start, size_t count, float* out) const {
+    size_t total = size();
+    if (start >= total) return;
+    count = std::min(count, total - start);
+    std::memcpy(out, samplesPtr() + start, count * sizeof(float));
+}
+
+size_t CaptureStore::bufferedBytes() const {
+    return size() * sizeof(float);
+}
+
+size_t CaptureStore::peakBytes() const {
+    return peak;
+}
+
+uint64_t CaptureStore::droppedSamples() const {
+    return dropped;
+}
+
+bool CaptureStore::isSpilled() const {
+    return spilled;
+}
+
+const float* CaptureStore::samplesPtr() const {
+    return spilled ? mapped : memory.data();
+}
+
+// Create the temporary file, map it and move the in-memory samples into it
+bool CaptureStore::startSpill() {
+#ifdef _WIN32
+    char tempDir[MAX_PATH];
+    if (!spillDir.empty()) {
+        strncpy(tempDir, spillDir.c_str(), MAX_PATH - 1);
+        tempDir[MAX_PATH - 1] = '\0';
+    } else if (GetTempPathA(MAX_PATH, tempDir) == 0) {
+        Logger::error("Failed to find temp directory for capture spill file");
+        return false;
+    }
+
+    char tempFile[MAX_PATH];
+    if (GetTempFileNameA(tempDir, "ttt", 0, tempFile) == 0) {
+        Logger::error("Failed to create capture spill file name");
+        return false;
+    }
+
+    HANDLE file = CreateFileA(tempFile, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        Logger::error("Failed to open capture spill file: " + std::string(tempFile));
+        return false;
+    }
+    fileHandle = file;
+    Logger::info("Spilling capture buffer to " + std::string(tempFile));
+#else
+    std::string pattern = (spillDir.empty() ? std::string("/tmp") : spillDir) + "/turbotalk-capture-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+
+    fileDescriptor = mkstemp(path.data());
+    if (fileDescriptor < 0) {
+        Logger::error("Failed to create capture spill file in " + pattern);
+        return false;
+    }
+    // Unlink right away so the file disappears with the process
+    unlink(path.data());
+    Logger::info("Spilling capture buffer to " + std::string(path.data()));
+#endif
+
+    if (!growMapping(std::max(memory.size() + SPILL_GROW_SAMPLES, maxMemorySamples))) {
+        releaseMapping();
+        return false;
+    }
+
+    // A block that overflows an empty store spills before anything was kept in memory
+    if (!memory.empty()) {
+        std::memcpy(mapped, memory.data(), memory.size() * sizeof(float));
+    }
+    mappedSize = memory.size();
+    spilled = true;
+    std::vector<float>().swap(memory);
+    return true;
+}
+
+// Resize the spill file and remap it so it can hold at least minSamples
+bool CaptureStore::growMapping(size_t minSamples) {
+    size_t newCapacity = std::max(minSamples, mappedCapacity + SPILL_GROW_SAMPLES);
+    newCapacity = std::min(newCapacity, std::max(maxSpillSamples, minSamples));
+    size_t newBytes = newCapacity * sizeof(float);
+
+    // Map the new size before releasing the old view so a failure keeps the data reachable
+#ifdef _WIN32
+    // Creating a mapping larger than the file extends the file
+    HANDLE mapping = CreateFileMappingA(static_cast<HANDLE>(fileHandle), NULL, PAGE_READWRITE,
+                                        static_cast<DWORD>(static_cast<uint64_t>(newBytes) >> 32),
+                                        static_cast<DWORD>(newBytes & 0xFFFFFFFFu), NULL);
+    if (!mapping) {
+        Logger::error("Failed to map capture spill file");
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, newBytes);
+    if (!view) {
+        Logger::error("Failed to map view of capture spill file");
+        CloseHandle(mapping);
+        return false;
+    }
+
+    if (mapped) {
+        UnmapViewOfFile(mapped);
+    }
+    if (mappingHandle) {
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+    }
+    mappingHandle = mapping;
+    mapped = static_cast<float*>(view);
+#else
+    if (ftruncate(fileDescriptor, static_cast<off_t>(newBytes)) != 0) {
+        Logger::error("Failed to grow capture spill file");
+        return false;
+    }
+
+    void* address = mmap(nullptr, newBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (address == MAP_FAILED) {
+        Logger::error("Failed to map capture spill file");
+        return false;
+    }
+
+    if (mapped) {
+        munmap(mapped, mappedCapacity * sizeof(float));
+    }
+    mapped = static_cast<float*>(address);
+#endif
+
+    mappedCapacity = newCapacity;
+    return true;
+}
+
+void CaptureStore::releaseMapping() {
+#ifdef _WIN32
+    if (mapped) {
+        UnmapViewOfFile(mapped);
+    }
+    if (mappingHandle) {
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+    }
+    if (fileHandle) {
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+    }
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (mapped) {
+        munmap(mapped, mappedCapacity * sizeof(float));
+    }
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
+    }
+    fileDescriptor = -1;
+#endif
+    mapped = nullptr;
+    mappedCapacity = 0;
+    mappedSize = 0;
+    spilled = false;
+}
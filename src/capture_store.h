@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Growable sample store for push-to-talk recordings with a hard memory
+// budget. Samples are kept in RAM up to maxMemorySamples; past that they are
+// either dropped or, if spilling is enabled, moved into a memory-mapped
+// temporary file that can grow up to maxSpillSamples.
+class CaptureStore {
+public:
+    CaptureStore();
+    ~CaptureStore();
+
+    CaptureStore(const CaptureStore&) = delete;
+    CaptureStore& operator=(const CaptureStore&) = delete;
+
+    // Set limits (in samples) and spill behaviour; clears current contents
+    void configure(size_t maxMemorySamples, bool spillEnabled, size_t maxSpillSamples, const std::string& spillDir);
+
+    // Drop all samples and release any spill file, keeping peak statistics
+    void clear();
+
+    // Append samples, returns how many were stored
+    size_t append(const float* samples, size_t count);
+
+    // Number of stored samples
+    size_t size() const;
+    bool empty() const;
+
+    // Copy out all samples / a sub-range of samples
+    std::vector<float> data() const;
+    void copyRange(size_t start, size_t count, float* out) const;
+
+    // Buffer accounting
+    size_t bufferedBytes() const;
+    size_t peakBytes() const;
+    uint64_t droppedSamples() const;
+    bool isSpilled() const;
+
+private:
+    const float* samplesPtr() const;
+    bool startSpill();
+    bool growMapping(size_t minSamples);
+    void releaseMapping();
+
+    // In-memory storage
+    std::vector<float> memory;
+    size_t maxMemorySamples = 0;
+
+    // Spill file storage
+    bool spillEnabled = false;
+    size_t maxSpillSamples = 0;
+    std::string spillDir;
+    bool spilled = false;
+    bool spillFailed = false;       // The spill file couldn't be created for this recording
+    float* mapped = nullptr;
+    size_t mappedCapacity = 0;
+    size_t mappedSize = 0;
+    void* fileHandle = nullptr;     // HANDLE on Windows
+    void* mappingHandle = nullptr;  // HANDLE on Windows
+    int fileDescriptor = -1;        // POSIX file descriptor
+
+    // Accounting
+    size_t peak = 0;
+    uint64_t dropped = 0;
+    bool limitWarningLogged = false;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+// Fixed-capacity circular buffer that always holds the most recent samples.
+// Appending never moves existing data; once full, new samples overwrite the
+// oldest ones. Contents are read through a two-span view (oldest first) so
+// callers can consume them without an intermediate copy.
+template <typename T>
+class CircularBuffer {
+public:
+    // Contents in chronological order: first span, then second span
+    struct View {
+        const T* first = nullptr;
+        size_t firstSize = 0;
+        const T* second = nullptr;
+        size_t secondSize = 0;
+
+        size_t size() const {
+            return firstSize + secondSize;
+        }
+    };
+
+    explicit CircularBuffer(size_t capacity = 0) {
+        reset(capacity);
+    }
+
+    // Change capacity and drop all contents
+    void reset(size_t capacity) {
+        buffer.assign(capacity, T());
+        clear();
+    }
+
+    void clear() {
+        writeIndex = 0;
+        count = 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    size_t capacity() const {
+        return buffer.size();
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    // Append samples, keeping only the most recent capacity() of them
+    void push(const T* data, size_t n) {
+        const size_t cap = buffer.size();
+        if (cap == 0 || n == 0) return;
+
+        // Only the tail of an oversized block can survive
+        if (n >= cap) {
+            std::memcpy(buffer.data(), data + (n - cap), cap * sizeof(T));
+            writeIndex = 0;
+            count = cap;
+            return;
+        }
+
+        const size_t firstPart = std::min(n, cap - writeIndex);
+        std::memcpy(buffer.data() + writeIndex, data, firstPart * sizeof(T));
+        std::memcpy(buffer.data(), data + firstPart, (n - firstPart) * sizeof(T));
+
+        writeIndex = (writeIndex + n) % cap;
+        count = std::min(cap, count + n);
+    }
+
+    View view() const {
+        View v;
+        if (count == 0) return v;
+
+        // Oldest sample sits count positions behind the write index
+        const size_t cap = buffer.size();
+        const size_t start = (writeIndex + cap - count) % cap;
+        v.first = buffer.data() + start;
+        v.firstSize = std::min(count, cap - start);
+        v.second = buffer.data();
+        v.secondSize = count - v.firstSize;
+        return v;
+    }
+
+private:
+    std::vector<T> buffer;
+    size_t writeIndex = 0;
+    size_t count = 0;
+};
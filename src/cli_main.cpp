@@ -0,0 +1,206 @@
+#include "settings.h"
+#include "logger.h"
+#include "audio_manager.h"
+#include "file_audio_source.h"
+#include "transcription.h"
+#include "latency_tracker.h"
+#include "trace.h"
+#include "text_processing.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Headless transcriber: reads audio from a file or pipe, writes transcripts to stdout
+
+static void printUsage() {
+    std::cerr << "Usage: turbotalk-cli [options] <input>\n"
+              << "\n"
+              << "Input:\n"
+              << "  file.wav | wav:<path>     RIFF/WAVE file\n"
+              << "  pcm:<path>                raw mono 32-bit float at the configured sample rate\n"
+              << "  pcm16:<path>              raw mono 16-bit signed at the configured sample rate\n"
+              << "  -                         raw 32-bit float from stdin\n"
+              << "\n"
+              << "Options:\n"
+              << "  -s, --settings <file>     settings file (default: settings.json)\n"
+              << "  -m, --model <file>        override whisper.model_path\n"
+              << "  -t, --threads <n>         override whisper.threads\n"
+              << "  -w, --whole               transcribe the input as one recording instead of\n"
+              << "                            speech-detected chunks\n"
+              << "      --trace <file>        write a Chrome trace of the pipeline (open in\n"
+              << "                            ui.perfetto.dev or chrome://tracing)\n"
+              << "  -h, --help                show this help\n";
+}
+
+int main(int argc, char** argv) {
+    // Logs go to stderr so stdout only carries transcripts
+    Logger::initStderr();
+
+    std::string settingsPath = "settings.json";
+    std::string modelPath;
+    std::string input;
+    int threads = 0;
+    bool wholeInput = false;
+    std::string tracePath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((arg == "-s" || arg == "--settings") && hasValue) {
+            settingsPath = argv[++i];
+        } else if ((arg == "-m" || arg == "--model") && hasValue) {
+            modelPath = argv[++i];
+        } else if ((arg == "-t" || arg == "--threads") && hasValue) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        } else if (arg == "-w" || arg == "--whole") {
+            wholeInput = true;
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (input.empty() && (arg == "-" || arg[0] != '-')) {
+            input = arg;
+        } else {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (input.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    Settings settings;
+    if (!settings.load(settingsPath)) {
+        Logger::error("Failed to load " + settingsPath);
+        return 1;
+    }
+    if (!modelPath.empty()) {
+        settings.modelPath = modelPath;
+    }
+    if (threads > 0) {
+        settings.threads = threads;
+    }
+    if (!tracePath.empty()) {
+        settings.tracing.enabled = true;
+        settings.tracing.outputPath = tracePath;
+    }
+    Trace::setThreadName("main");
+    if (settings.tracing.enabled) {
+        Trace::start(settings.tracing.maxEventsPerThread);
+    }
+
+    std::unique_ptr<AudioSource> source = createFileAudioSource(input);
+    if (!source) {
+        Logger::error("turbotalk-cli needs a file or pipe input, not an audio device");
+        return 1;
+    }
+
+    AudioManager audioManager(settings);
+    if (!audioManager.init(std::move(source))) {
+        Logger::error("AudioManager initialization failed");
+        return 1;
+    }
+
+    Transcription transcription(settings);
+    if (!transcription.init()) {
+        Logger::error("Transcription initialization failed");
+        return 1;
+    }
+
+    LatencyTracker latencyTracker(settings.sampleRate);
+    auto startTime = std::chrono::steady_clock::now();
+
+    if (wholeInput) {
+        // Push-to-talk path: sentences ended by a pause are decoded while the input is
+        // still being read, the rest once it ends; the parts are printed as one line
+        std::vector<std::future<TranscriptionResult>> parts;
+        audioManager.startRecording();
+        while (!audioManager.isEndOfStream()) {
+            if (audioManager.hasRecordingSegment()) {
+                parts.push_back(transcription.submit(audioManager.takeRecordingSegment()));
+                continue;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        audioManager.stopRecording();
+        parts.push_back(transcription.submit(audioManager.getRecording()));
+
+        std::string line;
+        std::vector<ChunkTiming> timings;
+        for (auto& part : parts) {
+            TranscriptionResult result = part.get();
+            std::string text = cleanTranscription(result.text);
+            timings.push_back(result.timing);
+            timings.back().postProcessed = ChunkTiming::Clock::now();
+            if (!text.empty()) {
+                line += (line.empty() ? "" : " ") + text;
+            }
+        }
+        if (!line.empty()) {
+            std::cout << line << std::endl;
+        }
+        for (ChunkTiming& timing : timings) {
+            timing.output = ChunkTiming::Clock::now();
+            latencyTracker.record(timing);
+        }
+    } else {
+        // Continuous path: one line per speech-detected chunk, in capture order. Chunks are
+        // submitted while the decoders have room and printed as the oldest one finishes.
+        std::deque<std::future<TranscriptionResult>> outstanding;
+        AudioChunk held;
+        auto printReady = [&](bool wait) {
+            while (!outstanding.empty() &&
+                   (wait || outstanding.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+                TranscriptionResult result = outstanding.front().get();
+                outstanding.pop_front();
+                // Later chunks decode with the text committed up to here as a prompt
+                transcription.commitContext(result);
+
+                ChunkTiming timing = result.timing;
+                std::string text = cleanTranscription(result.text);
+                timing.postProcessed = ChunkTiming::Clock::now();
+                if (!text.empty()) {
+                    std::cout << text << std::endl;
+                }
+                timing.output = ChunkTiming::Clock::now();
+                latencyTracker.record(timing);
+            }
+        };
+
+        audioManager.setContinuousMode(true);
+        audioManager.startRecording();
+        while (!audioManager.isEndOfStream() || audioManager.hasNewContinuousAudio() || !held.empty()) {
+            printReady(false);
+            if (held.empty() && audioManager.hasNewContinuousAudio()) {
+                held = audioManager.getContinuousAudioChunk();
+            }
+            if (held.empty() || !transcription.canSubmit(held)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                continue;
+            }
+            outstanding.push_back(transcription.submit(std::move(held), true));
+            held = AudioChunk();
+        }
+        printReady(true);
+        audioManager.stopRecording();
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    double audioSeconds = static_cast<double>(audioManager.getStreamPosition()) / settings.sampleRate;
+    Logger::info("Transcribed " + std::to_string(audioSeconds) + " s of audio in " +
+                 std::to_string(elapsed) + " s");
+    transcription.logRouteStats();
+    latencyTracker.log();
+    if (Trace::isEnabled()) {
+        Trace::writeJson(settings.tracing.outputPath);
+    }
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include "command_grammar.h"
+#include <cctype>
+#include <set>
+
+// Lowercase, keep letters and digits, and collapse everything else to single spaces
+static std::string normalizePhrase(const std::string& input) {
+    std::string result;
+    bool pendingSpace = false;
+    for (unsigned char c : input) {
+        if (c < 128 && std::isalnum(c)) {
+            if (pendingSpace && !result.empty()) {
+                result += ' ';
+            }
+            pendingSpace = false;
+            result += static_cast<char>(std::tolower(c));
+        } else {
+            pendingSpace = true;
+        }
+    }
+    return result;
+}
+
+static std::set<std::string> normalizePhrases(const std::vector<std::string>& phrases) {
+    std::set<std::string> result;
+    for (const auto& phrase : phrases) {
+        std::string normalized = normalizePhrase(phrase);
+        if (!normalized.empty()) {
+            result.insert(normalized);
+        }
+    }
+    return result;
+}
+
+static whisper_grammar_element element(whisper_gretype type, uint32_t value) {
+    whisper_grammar_element e;
+    e.type = type;
+    e.value = value;
+    return e;
+}
+
+CommandGrammar::CommandGrammar(const CommandVocabulary& vocabulary) {
+    std::set<std::string> fixed = normalizePhrases(vocabulary.phrases);
+    std::set<std::string> movement = normalizePhrases(vocabulary.movementPhrases);
+    std::set<std::string> prefixes = normalizePhrases(vocabulary.keyPrefixes);
+    std::set<std::string> keys = normalizePhrases(vocabulary.keyNames);
+    if (keys.empty()) {
+        prefixes.clear();
+    }
+    if (fixed.empty() && movement.empty() && prefixes.empty()) {
+        return;
+    }
+
+    // Rule indices first; the rules reference each other by index
+    size_t root = addRule();
+    size_t body = addRule();
+    separatorRule = addRule();
+    size_t ending = addRule();
+    size_t count = addRule();
+    size_t digits = addRule();
+    size_t keyList = addRule();
+    size_t key = addRule();
+
+    // root ::= " " body ending
+    Rule& rootRule = ruleElements[root];
+    rootRule.push_back(element(WHISPER_GRETYPE_CHAR, ' '));
+    rootRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(body)));
+    rootRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(ending)));
+    rootRule.push_back(element(WHISPER_GRETYPE_END, 0));
+
+    // body ::= fixed phrase | movement phrase count | key prefix separator keyList
+    Rule& bodyRule = ruleElements[body];
+    for (const auto& phrase : fixed) {
+        appendAlternative(bodyRule);
+        appendLiteral(bodyRule, phrase);
+    }
+    for (const auto& phrase : movement) {
+        appendAlternative(bodyRule);
+        appendLiteral(bodyRule, phrase);
+        bodyRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(count)));
+    }
+    for (const auto& prefix : prefixes) {
+        appendAlternative(bodyRule);
+        appendLiteral(bodyRule, prefix);
+        bodyRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(separatorRule)));
+        bodyRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(keyList)));
+    }
+    bodyRule.push_back(element(WHISPER_GRETYPE_END, 0));
+    phrases = fixed.size() + movement.size() + prefixes.size();
+
+    // separator ::= ", " | " "
+    Rule& separator = ruleElements[separatorRule];
+    separator.push_back(element(WHISPER_GRETYPE_CHAR, ','));
+    separator.push_back(element(WHISPER_GRETYPE_CHAR, ' '));
+    separator.push_back(element(WHISPER_GRETYPE_ALT, 0));
+    separator.push_back(element(WHISPER_GRETYPE_CHAR, ' '));
+    separator.push_back(element(WHISPER_GRETYPE_END, 0));
+
+    // ending ::= [.!?] | (nothing)
+    Rule& endingRule = ruleElements[ending];
+    endingRule.push_back(element(WHISPER_GRETYPE_CHAR, '.'));
+    endingRule.push_back(element(WHISPER_GRETYPE_CHAR_ALT, '!'));
+    endingRule.push_back(element(WHISPER_GRETYPE_CHAR_ALT, '?'));
+    endingRule.push_back(element(WHISPER_GRETYPE_ALT, 0));
+    endingRule.push_back(element(WHISPER_GRETYPE_END, 0));
+
+    // count ::= separator digits | (nothing)
+    Rule& countRule = ruleElements[count];
+    countRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(separatorRule)));
+    countRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(digits)));
+    countRule.push_back(element(WHISPER_GRETYPE_ALT, 0));
+    countRule.push_back(element(WHISPER_GRETYPE_END, 0));
+
+    // digits ::= [0-9] digits | [0-9]
+    Rule& digitsRule = ruleElements[digits];
+    digitsRule.push_back(element(WHISPER_GRETYPE_CHAR, '0'));
+    digitsRule.push_back(element(WHISPER_GRETYPE_CHAR_RNG_UPPER, '9'));
+    digitsRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(digits)));
+    digitsRule.push_back(element(WHISPER_GRETYPE_ALT, 0));
+    digitsRule.push_back(element(WHISPER_GRETYPE_CHAR, '0'));
+    digitsRule.push_back(element(WHISPER_GRETYPE_CHAR_RNG_UPPER, '9'));
+    digitsRule.push_back(element(WHISPER_GRETYPE_END, 0));
+
+    // keyList ::= key separator keyList | key
+    Rule& keyListRule = ruleElements[keyList];
+    keyListRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(key)));
+    keyListRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(separatorRule)));
+    keyListRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(keyList)));
+    keyListRule.push_back(element(WHISPER_GRETYPE_ALT, 0));
+    keyListRule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(key)));
+    keyListRule.push_back(element(WHISPER_GRETYPE_END, 0));
+
+    // key ::= one of the key names
+    Rule& keyRule = ruleElements[key];
+    for (const auto& name : keys) {
+        appendAlternative(keyRule);
+        appendLiteral(keyRule, name);
+    }
+    if (keys.empty()) {
+        // Unreachable without prefixes, but every rule needs at least one alternative
+        keyRule.push_back(element(WHISPER_GRETYPE_CHAR, ' '));
+    }
+    keyRule.push_back(element(WHISPER_GRETYPE_END, 0));
+
+    // whisper wants an array of pointers to the rules; the rules no longer change
+    for (const auto& rule : ruleElements) {
+        rulePointers.push_back(rule.data());
+    }
+}
+
+bool CommandGrammar::empty() const {
+    return ruleElements.empty();
+}
+
+const whisper_grammar_element** CommandGrammar::rules() const {
+    // whisper takes a non-const array but only reads it
+    return const_cast<const whisper_grammar_element**>(rulePointers.data());
+}
+
+size_t CommandGrammar::ruleCount() const {
+    return rulePointers.size();
+}
+
+size_t CommandGrammar::startRule() const {
+    return 0;
+}
+
+size_t CommandGrammar::phraseCount() const {
+    return phrases;
+}
+
+size_t CommandGrammar::addRule() {
+    ruleElements.push_back(Rule());
+    return ruleElements.size() - 1;
+}
+
+// Letters match either case and spaces match the separator rule
+void CommandGrammar::appendLiteral(Rule& rule, const std::string& text) const {
+    for (unsigned char c : text) {
+        if (c == ' ') {
+            rule.push_back(element(WHISPER_GRETYPE_RULE_REF, static_cast<uint32_t>(separatorRule)));
+        } else if (std::isalpha(c)) {
+            rule.push_back(element(WHISPER_GRETYPE_CHAR, static_cast<uint32_t>(std::tolower(c))));
+            rule.push_back(element(WHISPER_GRETYPE_CHAR_ALT, static_cast<uint32_t>(std::toupper(c))));
+        } else {
+            rule.push_back(element(WHISPER_GRETYPE_CHAR, c));
+        }
+    }
+}
+
+void CommandGrammar::appendAlternative(Rule& rule) const {
+    if (!rule.empty()) {
+        rule.push_back(element(WHISPER_GRETYPE_ALT, 0));
+    }
+}
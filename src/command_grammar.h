@@ -0,0 +1,43 @@
+#pragma once
+
+#include <whisper.h>
+#include <string>
+#include <vector>
+
+// The closed set of things that can be said in command (mouse) mode
+struct CommandVocabulary {
+    std::vector<std::string> phrases;          // Fixed commands ("jarvis text mode", "click")
+    std::vector<std::string> movementPhrases;  // Commands that may take a pixel count ("left 200")
+    std::vector<std::string> keyPrefixes;      // Followed by one or more key names ("jarvis press")
+    std::vector<std::string> keyNames;         // Names the keyboard understands ("enter", "f5", "a")
+};
+
+// Compiles a CommandVocabulary into whisper grammar rules for constrained sampling.
+// Letters match in either case, words may be separated by ", " or " ", numbers are
+// digits (which is what the mouse parser reads) and an utterance may end in . ! or ?
+class CommandGrammar {
+public:
+    explicit CommandGrammar(const CommandVocabulary& vocabulary);
+
+    bool empty() const;
+
+    // Arguments for whisper_full_params::grammar_rules / n_grammar_rules / i_start_rule
+    const whisper_grammar_element** rules() const;
+    size_t ruleCount() const;
+    size_t startRule() const;
+
+    // Number of alternatives the grammar accepts at the top level
+    size_t phraseCount() const;
+
+private:
+    typedef std::vector<whisper_grammar_element> Rule;
+
+    size_t addRule();
+    void appendLiteral(Rule& rule, const std::string& text) const;
+    void appendAlternative(Rule& rule) const;
+
+    std::vector<Rule> ruleElements;
+    std::vector<const whisper_grammar_element*> rulePointers;
+    size_t separatorRule = 0;
+    size_t phrases = 0;
+};
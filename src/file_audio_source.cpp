@@ -0,0 +1,368 @@
+#include "file_audio_source.h"
+#include "logger.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+// WAVE format tags
+static const int WAVE_FORMAT_PCM = 1;
+static const int WAVE_FORMAT_IEEE_FLOAT = 3;
+static const int WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// Samples per block handed to the sink, matching the device callback size
+static const size_t STREAM_BLOCK_SAMPLES = 1024;
+
+static uint32_t readLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static uint16_t readLE16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+// ---------------------------------------------------------------------------
+// StreamAudioSource
+
+StreamAudioSource::~StreamAudioSource() {
+    // Derived classes close their own stream (closeStream() is virtual); only the reader thread is ours
+    running.store(false);
+    if (reader.joinable()) {
+        reader.join();
+    }
+}
+
+bool StreamAudioSource::open(int sampleRate, AudioSink* audioSink) {
+    sink = audioSink;
+    block.resize(STREAM_BLOCK_SAMPLES);
+    blockCount = 0;
+    blockOffset = 0;
+    finished.store(false);
+
+    if (!openStream(sampleRate)) {
+        return false;
+    }
+    Logger::info("Opened " + describe());
+    return true;
+}
+
+void StreamAudioSource::start() {
+    if (running.load() || finished.load()) return;
+    
+    // Reap a reader that exited because capture was stopped
+    if (reader.joinable()) {
+        reader.join();
+    }
+    running.store(true);
+    reader = std::thread(&StreamAudioSource::readerLoop, this);
+}
+
+void StreamAudioSource::stop() {
+    // The sink stops accepting samples when capture stops, which releases the reader
+    running.store(false);
+    if (reader.joinable()) {
+        reader.join();
+    }
+}
+
+void StreamAudioSource::close() {
+    stop();
+    closeStream();
+}
+
+int StreamAudioSource::blockSize() const {
+    return static_cast<int>(STREAM_BLOCK_SAMPLES);
+}
+
+bool StreamAudioSource::isRealtime() const {
+    return false;
+}
+
+std::FILE* StreamAudioSource::openInput(const std::string& path) {
+    if (path == "-") {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        return stdin;
+    }
+    return std::fopen(path.c_str(), "rb");
+}
+
+void StreamAudioSource::readerLoop() {
+    Trace::setThreadName("file reader");
+    while (running.load()) {
+        // Fetch the next block once the previous one was fully accepted
+        if (blockOffset >= blockCount) {
+            blockCount = readSamples(block.data(), block.size());
+            blockOffset = 0;
+            if (blockCount == 0) {
+                finished.store(true);
+                running.store(false);
+                Logger::info("End of " + describe());
+                sink->endOfStream();
+                return;
+            }
+        }
+
+        size_t accepted = sink->pushBlocking(block.data() + blockOffset, blockCount - blockOffset);
+        blockOffset += accepted;
+        if (accepted == 0) {
+            // Capture stopped; keep the rest of the block for the next start()
+            running.store(false);
+            return;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// WavFileSource
+
+WavFileSource::WavFileSource(const std::string& path) : path(path) {}
+
+WavFileSource::~WavFileSource() {
+    close();
+}
+
+std::string WavFileSource::describe() const {
+    return "WAV file '" + path + "' (" + std::to_string(fileRate) + " Hz, " +
+           std::to_string(channels) + " ch, " + std::to_string(bitsPerSample) + " bit)";
+}
+
+double WavFileSource::durationSeconds() const {
+    return fileRate > 0 ? static_cast<double>(totalFrames) / fileRate : 0.0;
+}
+
+bool WavFileSource::openStream(int rate) {
+    outputRate = rate;
+    file = openInput(path);
+    if (!file) {
+        Logger::error("Could not open WAV file: " + path);
+        return false;
+    }
+
+    if (!parseHeader()) {
+        closeStream();
+        return false;
+    }
+
+    if (fileRate != outputRate) {
+        Logger::info("Resampling " + path + " from " + std::to_string(fileRate) +
+                     " Hz to " + std::to_string(outputRate) + " Hz");
+    }
+    return true;
+}
+
+// Walk the RIFF chunks up to the start of the sample data
+bool WavFileSource::parseHeader() {
+    uint8_t header[12];
+    if (std::fread(header, 1, 12, file) != 12 ||
+        std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "WAVE", 4) != 0) {
+        Logger::error("Not a RIFF/WAVE file: " + path);
+        return false;
+    }
+
+    bool haveFormat = false;
+    uint8_t chunkHeader[8];
+    while (std::fread(chunkHeader, 1, 8, file) == 8) {
+        uint32_t chunkSize = readLE32(chunkHeader + 4);
+
+        if (std::memcmp(chunkHeader, "fmt ", 4) == 0) {
+            std::vector<uint8_t> fmt(chunkSize);
+            if (chunkSize < 16 || std::fread(fmt.data(), 1, chunkSize, file) != chunkSize) {
+                Logger::error("Truncated WAV format chunk: " + path);
+                return false;
+            }
+            formatTag = readLE16(fmt.data());
+            channels = readLE16(fmt.data() + 2);
+            fileRate = static_cast<int>(readLE32(fmt.data() + 4));
+            bitsPerSample = readLE16(fmt.data() + 14);
+
+            // The real format of an extensible file is the first field of its sub-format GUID
+            if (formatTag == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 26) {
+                formatTag = readLE16(fmt.data() + 24);
+            }
+            if (chunkSize & 1) std::fgetc(file);
+            haveFormat = true;
+        } else if (std::memcmp(chunkHeader, "data", 4) == 0) {
+            if (!haveFormat) {
+                Logger::error("WAV data chunk before format chunk: " + path);
+                return false;
+            }
+            dataBytesLeft = chunkSize;
+            break;
+        } else {
+            // Skip chunks we don't need (LIST, fact, ...), honouring the pad byte
+            for (uint32_t i = 0; i < chunkSize + (chunkSize & 1); i++) {
+                if (std::fgetc(file) == EOF) break;
+            }
+        }
+    }
+
+    bool supported = channels > 0 && fileRate > 0 &&
+                     ((formatTag == WAVE_FORMAT_PCM && (bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32)) ||
+                      (formatTag == WAVE_FORMAT_IEEE_FLOAT && bitsPerSample == 32));
+    if (!haveFormat || !supported) {
+        Logger::error("Unsupported WAV format in " + path + " (format " + std::to_string(formatTag) +
+                      ", " + std::to_string(bitsPerSample) + " bit)");
+        return false;
+    }
+
+    // Streamed WAVs may carry a placeholder size; reading still stops at end of file
+    size_t frameBytes = static_cast<size_t>(channels) * (bitsPerSample / 8);
+    totalFrames = dataBytesLeft / frameBytes;
+    return true;
+}
+
+// Decode up to maxFrames frames into the mono input buffer, returns frames read
+size_t WavFileSource::readFrames(size_t maxFrames) {
+    size_t bytesPerSample = bitsPerSample / 8;
+    size_t frameBytes = static_cast<size_t>(channels) * bytesPerSample;
+    size_t frames = std::min<uint64_t>(maxFrames, dataBytesLeft / frameBytes);
+    if (frames == 0) return 0;
+
+    raw.resize(frames * frameBytes);
+    frames = std::fread(raw.data(), frameBytes, frames, file);
+    dataBytesLeft -= frames * frameBytes;
+
+    const uint8_t* p = raw.data();
+    for (size_t f = 0; f < frames; f++) {
+        // Downmix all channels to mono
+        float sum = 0.0f;
+        for (int c = 0; c < channels; c++, p += bytesPerSample) {
+            if (formatTag == WAVE_FORMAT_IEEE_FLOAT) {
+                float value;
+                std::memcpy(&value, p, sizeof(float));
+                sum += value;
+            } else if (bitsPerSample == 16) {
+                sum += static_cast<int16_t>(readLE16(p)) / 32768.0f;
+            } else if (bitsPerSample == 24) {
+                // Assemble unsigned and sign-extend arithmetically; shifting into the sign bit is UB
+                uint32_t raw = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                               (static_cast<uint32_t>(p[2]) << 16);
+                int32_t value = static_cast<int32_t>(raw) - ((raw & 0x800000u) ? 0x1000000 : 0);
+                sum += value / 8388608.0f;
+            } else {
+                sum += static_cast<int32_t>(readLE32(p)) / 2147483648.0f;
+            }
+        }
+        input.push_back(sum / channels);
+    }
+    return frames;
+}
+
+size_t WavFileSource::readSamples(float* out, size_t maxSamples) {
+    // Same rate: decode straight through
+    if (fileRate == outputRate) {
+        input.clear();
+        size_t frames = readFrames(maxSamples);
+        std::copy(input.begin(), input.end(), out);
+        input.clear();
+        return frames;
+    }
+
+    // Linear interpolation between neighbouring input samples
+    const double step = static_cast<double>(fileRate) / outputRate;
+    size_t produced = 0;
+    while (produced < maxSamples) {
+        size_t index = static_cast<size_t>(inputPos);
+        if (index + 1 >= input.size()) {
+            if (inputDone || readFrames(STREAM_BLOCK_SAMPLES) == 0) {
+                inputDone = true;
+                break;
+            }
+            continue;
+        }
+        float frac = static_cast<float>(inputPos - index);
+        out[produced++] = input[index] + (input[index + 1] - input[index]) * frac;
+        inputPos += step;
+    }
+
+    // Drop input that has been fully consumed
+    size_t consumed = std::min(static_cast<size_t>(inputPos), input.size());
+    input.erase(input.begin(), input.begin() + consumed);
+    inputPos -= consumed;
+    return produced;
+}
+
+void WavFileSource::closeStream() {
+    if (file && file != stdin) {
+        std::fclose(file);
+    }
+    file = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// PcmStreamSource
+
+PcmStreamSource::PcmStreamSource(const std::string& path, Format format) : path(path), format(format) {}
+
+PcmStreamSource::~PcmStreamSource() {
+    close();
+}
+
+std::string PcmStreamSource::describe() const {
+    return "raw PCM stream '" + path + "' (" + (format == Format::FLOAT32 ? "f32" : "s16") + ")";
+}
+
+bool PcmStreamSource::openStream(int) {
+    file = openInput(path);
+    if (!file) {
+        Logger::error("Could not open PCM stream: " + path);
+        return false;
+    }
+    return true;
+}
+
+size_t PcmStreamSource::readSamples(float* out, size_t maxSamples) {
+    if (format == Format::FLOAT32) {
+        return std::fread(out, sizeof(float), maxSamples, file);
+    }
+
+    raw16.resize(maxSamples);
+    size_t count = std::fread(raw16.data(), sizeof(int16_t), maxSamples, file);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = raw16[i] / 32768.0f;
+    }
+    return count;
+}
+
+void PcmStreamSource::closeStream() {
+    if (file && file != stdin) {
+        std::fclose(file);
+    }
+    file = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+
+std::unique_ptr<AudioSource> createFileAudioSource(const std::string& spec) {
+    if (spec.empty() || spec == "device") {
+        return nullptr;
+    }
+
+    auto endsWith = [](const std::string& s, const std::string& suffix) {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+    if (spec.rfind("wav:", 0) == 0) {
+        return std::unique_ptr<AudioSource>(new WavFileSource(spec.substr(4)));
+    }
+    if (spec.rfind("pcm16:", 0) == 0) {
+        return std::unique_ptr<AudioSource>(new PcmStreamSource(spec.substr(6), PcmStreamSource::Format::INT16));
+    }
+    if (spec.rfind("pcm:", 0) == 0) {
+        return std::unique_ptr<AudioSource>(new PcmStreamSource(spec.substr(4), PcmStreamSource::Format::FLOAT32));
+    }
+    if (endsWith(spec, ".wav") || endsWith(spec, ".WAV")) {
+        return std::unique_ptr<AudioSource>(new WavFileSource(spec));
+    }
+
+    // Anything else is treated as raw float samples (e.g. "-" for stdin)
+    return std::unique_ptr<AudioSource>(new PcmStreamSource(spec, PcmStreamSource::Format::FLOAT32));
+}
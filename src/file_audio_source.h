@@ -0,0 +1,116 @@
+#pragma once
+
+#include "audio_source.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Base for sources that read a byte stream on their own thread and deliver
+// audio as fast as the consumer accepts it. Timing downstream is driven by
+// the sample count, so results don't depend on wall-clock speed.
+class StreamAudioSource : public AudioSource {
+public:
+    ~StreamAudioSource() override;
+
+    bool open(int sampleRate, AudioSink* sink) override;
+    void start() override;
+    void stop() override;
+    void close() override;
+    int blockSize() const override;
+    bool isRealtime() const override;
+
+protected:
+    // Open the underlying stream, producing audio at outputRate
+    virtual bool openStream(int outputRate) = 0;
+
+    // Read up to maxSamples mono samples; 0 means end of stream
+    virtual size_t readSamples(float* out, size_t maxSamples) = 0;
+
+    virtual void closeStream() = 0;
+
+    // Open a path for binary reading, "-" meaning stdin
+    static std::FILE* openInput(const std::string& path);
+
+private:
+    void readerLoop();
+
+    AudioSink* sink = nullptr;
+    std::thread reader;
+    std::atomic<bool> running{false};
+    std::atomic<bool> finished{false};
+
+    // Block read from the stream but not yet accepted by the sink
+    std::vector<float> block;
+    size_t blockCount = 0;
+    size_t blockOffset = 0;
+};
+
+// RIFF/WAVE file (PCM 16/24/32-bit or 32-bit float), downmixed to mono and
+// linearly resampled to the application rate if needed
+class WavFileSource : public StreamAudioSource {
+public:
+    explicit WavFileSource(const std::string& path);
+    ~WavFileSource() override;
+    std::string describe() const override;
+
+    // Duration of the file in seconds (valid after open)
+    double durationSeconds() const;
+
+protected:
+    bool openStream(int outputRate) override;
+    size_t readSamples(float* out, size_t maxSamples) override;
+    void closeStream() override;
+
+private:
+    bool parseHeader();
+    size_t readFrames(size_t maxFrames);
+
+    std::string path;
+    std::FILE* file = nullptr;
+    int formatTag = 0;
+    int channels = 0;
+    int fileRate = 0;
+    int bitsPerSample = 0;
+    uint64_t dataBytesLeft = 0;
+    uint64_t totalFrames = 0;
+
+    // Resampling state: decoded mono input and fractional read position
+    int outputRate = 0;
+    std::vector<uint8_t> raw;
+    std::vector<float> input;
+    double inputPos = 0.0;
+    bool inputDone = false;
+};
+
+// Raw headerless PCM from a file, named pipe or stdin ("-"), already mono at
+// the application rate
+class PcmStreamSource : public StreamAudioSource {
+public:
+    enum class Format {
+        FLOAT32,  // 32-bit float little-endian
+        INT16     // 16-bit signed little-endian
+    };
+
+    PcmStreamSource(const std::string& path, Format format);
+    ~PcmStreamSource() override;
+    std::string describe() const override;
+
+protected:
+    bool openStream(int outputRate) override;
+    size_t readSamples(float* out, size_t maxSamples) override;
+    void closeStream() override;
+
+private:
+    std::string path;
+    Format format;
+    std::FILE* file = nullptr;
+    std::vector<int16_t> raw16;
+};
+
+// Create a file/pipe source from a spec such as "wav:talk.wav", "pcm:/tmp/fifo",
+// "pcm16:-" or a bare path ending in .wav. Returns nullptr for "device" or "".
+std::unique_ptr<AudioSource> createFileAudioSource(const std::string& spec);
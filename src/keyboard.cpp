@@ -1,5 +1,6 @@
 #include "keyboard.h"
 #include "logger.h"
+#include "trace.h"
 #include <algorithm>
 #include <cctype>
 #include <regex>
@@ -10,6 +11,7 @@ Keyboard::Keyboard() {
 }
 
 void Keyboard::typeText(const std::string& text) {
+    TRACE_SCOPE("Keyboard::typeText");
     Logger::info("Typing text: " + text);
 
     for (char c : text) {
@@ -247,6 +249,14 @@ std::vector<std::string> Keyboard::parseKeyNames(const std::string& command) {
     return result;
 }
 
+std::vector<std::string> Keyboard::getKeyNames() const {
+    std::vector<std::string> names;
+    for (const auto& entry : keyNameMap) {
+        names.push_back(entry.first);
+    }
+    return names;
+}
+
 bool Keyboard::processKeyCommand(const std::string& command) {
     Logger::info("Processing key command: '" + command + "'");
     
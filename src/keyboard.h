@@ -20,6 +20,9 @@ public:
     
     // Process a key command from a voice input
     bool processKeyCommand(const std::string& command);
+    
+    // All key names pressKey() accepts
+    std::vector<std::string> getKeyNames() const;
 
 private:
     // Initialize the key name to virtual key code mapping
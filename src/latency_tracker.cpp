@@ -0,0 +1,144 @@
+#include "latency_tracker.h"
+#include "logger.h"
+#include <algorithm>
+
+// Bucket upper bounds in milliseconds, roughly logarithmic from 1 ms to 30 s
+static const double BOUNDS_MS[] = {
+    1, 2, 3, 5, 7, 10, 15, 20, 30, 50, 70, 100, 150, 200, 300, 500, 700,
+    1000, 1500, 2000, 3000, 5000, 7000, 10000, 15000, 20000, 30000
+};
+static const size_t BOUND_COUNT = sizeof(BOUNDS_MS) / sizeof(BOUNDS_MS[0]);
+
+static double elapsedMs(ChunkTiming::Clock::time_point from, ChunkTiming::Clock::time_point to) {
+    return std::max(0.0, std::chrono::duration<double, std::milli>(to - from).count());
+}
+
+LatencyTracker::LatencyTracker(int sampleRate) : sampleRate(sampleRate > 0 ? sampleRate : 16000) {
+    reset();
+}
+
+void LatencyTracker::record(const ChunkTiming& timing) {
+    if (!ChunkTiming::isSet(timing.endpoint)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    double endpointMs = static_cast<double>(timing.endpointSample - timing.speechEndSample) * 1000.0 / sampleRate;
+    add(ENDPOINT, endpointMs);
+
+    // Each stage runs from the previous timestamp that was set
+    const ChunkTiming::Clock::time_point* previous = &timing.endpoint;
+    const ChunkTiming::Clock::time_point* stamps[] = {
+        &timing.enqueue, &timing.decodeStart, &timing.decodeEnd, &timing.postProcessed, &timing.output
+    };
+    const Stage stages[] = {HANDOFF, QUEUE, DECODE, POSTPROCESS, OUTPUT};
+    for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++) {
+        if (!ChunkTiming::isSet(*stamps[i])) {
+            continue;
+        }
+        add(stages[i], elapsedMs(*previous, *stamps[i]));
+        previous = stamps[i];
+    }
+
+    if (ChunkTiming::isSet(timing.output)) {
+        add(TOTAL, endpointMs + elapsedMs(timing.endpoint, timing.output));
+    }
+}
+
+LatencyTracker::Summary LatencyTracker::summary(Stage stage) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Histogram& histogram = histograms[stage];
+    Summary result;
+    result.count = histogram.count;
+    if (histogram.count == 0) {
+        return result;
+    }
+    result.meanMs = histogram.sumMs / histogram.count;
+    result.p50Ms = percentile(histogram, 0.50);
+    result.p90Ms = percentile(histogram, 0.90);
+    result.p99Ms = percentile(histogram, 0.99);
+    result.maxMs = histogram.maxMs;
+    return result;
+}
+
+void LatencyTracker::log() const {
+    bool any = false;
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        Stage stage = static_cast<Stage>(i);
+        Summary stats = summary(stage);
+        if (stats.count == 0) {
+            continue;
+        }
+        any = true;
+
+        std::string buckets;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const Histogram& histogram = histograms[stage];
+            for (size_t b = 0; b < histogram.buckets.size(); b++) {
+                if (histogram.buckets[b] == 0) {
+                    continue;
+                }
+                std::string bound = b < BOUND_COUNT ? "<=" + std::to_string(static_cast<int>(BOUNDS_MS[b]))
+                                                    : ">" + std::to_string(static_cast<int>(BOUNDS_MS[BOUND_COUNT - 1]));
+                buckets += " " + bound + ":" + std::to_string(histogram.buckets[b]);
+            }
+        }
+
+        Logger::info("Latency " + std::string(stageName(stage)) + ": " + std::to_string(stats.count) +
+                     " chunk(s), mean " + std::to_string(static_cast<int>(stats.meanMs)) +
+                     " ms, p50 " + std::to_string(static_cast<int>(stats.p50Ms)) +
+                     " ms, p90 " + std::to_string(static_cast<int>(stats.p90Ms)) +
+                     " ms, p99 " + std::to_string(static_cast<int>(stats.p99Ms)) +
+                     " ms, max " + std::to_string(static_cast<int>(stats.maxMs)) + " ms |" + buckets);
+    }
+    if (!any) {
+        Logger::info("Latency: no chunks recorded yet");
+    }
+}
+
+void LatencyTracker::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Histogram& histogram : histograms) {
+        histogram.buckets.assign(BOUND_COUNT + 1, 0);
+        histogram.count = 0;
+        histogram.sumMs = 0.0;
+        histogram.maxMs = 0.0;
+    }
+}
+
+const char* LatencyTracker::stageName(Stage stage) {
+    switch (stage) {
+        case ENDPOINT: return "endpoint";
+        case HANDOFF: return "handoff";
+        case QUEUE: return "queue";
+        case DECODE: return "decode";
+        case POSTPROCESS: return "postprocess";
+        case OUTPUT: return "output";
+        case TOTAL: return "total";
+        default: return "unknown";
+    }
+}
+
+// Called with the mutex held
+void LatencyTracker::add(Stage stage, double ms) {
+    Histogram& histogram = histograms[stage];
+    size_t bucket = std::lower_bound(BOUNDS_MS, BOUNDS_MS + BOUND_COUNT, ms) - BOUNDS_MS;
+    histogram.buckets[bucket]++;
+    histogram.count++;
+    histogram.sumMs += ms;
+    histogram.maxMs = std::max(histogram.maxMs, ms);
+}
+
+// Called with the mutex held
+double LatencyTracker::percentile(const Histogram& histogram, double fraction) const {
+    uint64_t target = static_cast<uint64_t>(fraction * (histogram.count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < histogram.buckets.size(); b++) {
+        seen += histogram.buckets[b];
+        if (seen >= target) {
+            return b < BOUND_COUNT ? std::min(BOUNDS_MS[b], histogram.maxMs) : histogram.maxMs;
+        }
+    }
+    return histogram.maxMs;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "audio_chunk.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Per-stage latency histograms built from the timestamps every chunk carries from the
+// end of speech to its output. Thread-safe; log() dumps them on demand.
+class LatencyTracker {
+public:
+    enum Stage {
+        ENDPOINT,     // Last speech to chunk closed (silence detection), on the capture clock
+        HANDOFF,      // Chunk closed to submitted for transcription
+        QUEUE,        // Submitted to picked up by a worker
+        DECODE,       // Whisper inference
+        POSTPROCESS,  // Decode finished to text cleaned and commands resolved
+        OUTPUT,       // Typing, mouse control or printing
+        TOTAL,        // Last speech to output complete
+        STAGE_COUNT
+    };
+
+    struct Summary {
+        uint64_t count = 0;
+        double meanMs = 0.0;
+        double p50Ms = 0.0;   // Percentiles are bucket upper bounds, capped at the maximum
+        double p90Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+    explicit LatencyTracker(int sampleRate);
+
+    // Add a chunk's stages; stages whose timestamps were never set are skipped
+    void record(const ChunkTiming& timing);
+
+    Summary summary(Stage stage) const;
+    void log() const;
+    void reset();
+
+    static const char* stageName(Stage stage);
+
+private:
+    struct Histogram {
+        std::vector<uint64_t> buckets;  // One per bound, plus overflow
+        uint64_t count = 0;
+        double sumMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    void add(Stage stage, double ms);
+    double percentile(const Histogram& histogram, double fraction) const;
+
+    int sampleRate;
+    mutable std::mutex mutex;
+    Histogram histograms[STAGE_COUNT];
+};
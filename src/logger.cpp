@@ -7,6 +7,12 @@ void Logger::init() {
     spdlog::set_level(spdlog::level::info);
 }
 
+void Logger::initStderr() {
+    auto console = spdlog::stderr_color_mt("console");
+    spdlog::set_default_logger(console);
+    spdlog::set_level(spdlog::level::info);
+}
+
 void Logger::info(const std::string& message) {
     spdlog::info(message);
 }
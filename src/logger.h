@@ -6,6 +6,8 @@
 class Logger {
 public:
     static void init();
+    // Log to stderr instead, keeping stdout free for program output
+    static void initStderr();
     static void info(const std::string& message);
     static void error(const std::string& message);
 };
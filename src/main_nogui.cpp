@@ -1,10 +1,15 @@
 #include "settings.h"
 #include "logger.h"
 #include "audio_manager.h"
+#include "sdl_audio_source.h"
+#include "file_audio_source.h"
 #include "transcription.h"
+#include "latency_tracker.h"
+#include "trace.h"
 #include "keyboard.h"
 #include "mouse.h"
 #include "hotkey.h"
+#include "text_processing.h"
 
 #ifdef USE_OVERLAY_UI
 #include "overlay_ui.h"
@@ -25,154 +30,29 @@ enum InputMode {
     MOUSE_MODE
 };
 
+// A transcription handed to the inference worker, dispatched in capture order
+struct PendingTranscription {
+    enum Kind {
+        PUSH_TO_TALK,          // Recording from the hotkey or silence auto-stop (after its segments)
+        PUSH_TO_TALK_SEGMENT,  // Sentence of a recording still in progress
+        CONTINUOUS             // Speech chunk from continuous mode
+    };
+    Kind kind;
+    std::future<TranscriptionResult> result;
+};
+
+// Audio taken from the audio manager that waits for room in its model's queue
+struct HeldChunk {
+    PendingTranscription::Kind kind;
+    AudioChunk audio;
+};
+
 // Voice command state tracking
 struct VoiceCommands {
     // No need for wake word state tracking anymore
     // We directly check for the wake word in each command
 };
 
-// Helper function to normalize text for command matching (static to limit scope to this file)
-static std::string normalizeText(const std::string& input) {
-    // Convert to lowercase
-    std::string result;
-    result.resize(input.size());
-    std::transform(input.begin(), input.end(), result.begin(), 
-                  [](unsigned char c){ return std::tolower(c); });
-    
-    // Remove punctuation
-    result.erase(std::remove_if(result.begin(), result.end(), 
-                 [](unsigned char c){ return std::ispunct(c); }), result.end());
-                 
-    return result;
-}
-
-// Check if text contains any command from a list of possible commands
-static bool containsAnyCommand(const std::string& text, const std::vector<std::string>& commands) {
-    for (const auto& cmd : commands) {
-        if (text.find(cmd) != std::string::npos) {
-            return true;
-        }
-    }
-    return false;
-}
-
-// Helper function to clean up transcription text
-static std::string cleanTranscription(const std::string& text) {
-    // Remove [BLANK_AUDIO] markers and other noise indicators
-    std::string result = text;
-    
-    // Define regex patterns for various noise indicators
-    std::regex noisePattern("\\s*\\[(BLANK_AUDIO|silence|keyboard|background|noise|typing|clicking|inaudible|music|sound|sounds).*?\\]\\s*");
-    
-    // Replace matches with a space
-    result = std::regex_replace(result, noisePattern, " ");
-    
-    // Trim extra whitespace
-    result = std::regex_replace(result, std::regex("\\s+"), " ");
-    
-    // Trim leading/trailing whitespace
-    result = std::regex_replace(result, std::regex("^\\s+|\\s+$"), "");
-    
-    return result;
-}
-
-// Remove duplicate words at the boundary of two strings
-static std::string mergeContinuousText(const std::string& previousText, const std::string& newText) {
-    if (previousText.empty()) {
-        return newText;
-    }
-    
-    // Convert both texts to lowercase for comparison
-    std::string prevLower = normalizeText(previousText);
-    std::string newLower = normalizeText(newText);
-    
-    // Extract last few words from previous text (up to 8 words for better context)
-    std::vector<std::string> prevWords;
-    size_t wordCount = 0;
-    
-    // Tokenize previous text into words
-    std::istringstream prevStream(prevLower);
-    std::string word;
-    std::vector<std::string> allPrevWords;
-    
-    while (prevStream >> word && wordCount < 20) { // Get up to 20 words
-        allPrevWords.push_back(word);
-        wordCount++;
-    }
-    
-    // Get last 8 words or all available words if less than 8
-    int wordsToUse = std::min(8, static_cast<int>(allPrevWords.size()));
-    prevWords.assign(allPrevWords.end() - wordsToUse, allPrevWords.end());
-    
-    // Find the best overlap point
-    size_t bestOverlapPos = 0;
-    size_t bestOverlapLength = 0;
-    size_t bestWordCount = 0;
-    
-    // Try different sequence lengths
-    for (size_t startIdx = 0; startIdx < prevWords.size(); startIdx++) {
-        std::string sequence;
-        
-        for (size_t i = startIdx; i < prevWords.size(); i++) {
-            if (!sequence.empty()) {
-                sequence += " ";
-            }
-            sequence += prevWords[i];
-            
-            // Check if this sequence is at the start of the new text
-            size_t pos = newLower.find(sequence);
-            if (pos == 0 && sequence.length() > bestOverlapLength) {
-                bestOverlapLength = sequence.length();
-                bestWordCount = i - startIdx + 1;
-                
-                // Find the position after the last matched word
-                size_t spacePos = newLower.find(' ', bestOverlapLength);
-                bestOverlapPos = (spacePos != std::string::npos) ? spacePos + 1 : newLower.length();
-            }
-        }
-    }
-    
-    // Preserve proper capitalization and punctuation
-    if (bestOverlapLength > 0 && bestOverlapPos > 0) {
-        // Use the new text after the overlap to maintain original capitalization
-        std::string mergedText = previousText;
-        
-        // If the last character is not punctuation or space, add a space
-        if (!mergedText.empty() && !std::ispunct(mergedText.back()) && !std::isspace(mergedText.back())) {
-            mergedText += " ";
-        }
-        
-        // Add remaining text from new chunk
-        if (bestOverlapPos < newText.length()) {
-            mergedText += newText.substr(bestOverlapPos);
-        }
-        
-        // Ensure proper spacing after punctuation
-        std::regex multipleSpaces("\\s+");
-        mergedText = std::regex_replace(mergedText, multipleSpaces, " ");
-        
-        return mergedText;
-    }
-    
-    // No overlap found, just append with a space or punctuation-aware join
-    if (!previousText.empty() && !std::ispunct(previousText.back()) && !std::isspace(previousText.back())) {
-        // If the new text starts with lowercase, just add a space
-        if (!newText.empty() && std::islower(newText[0])) {
-            return previousText + " " + newText;
-        }
-        // If new text starts with uppercase, it might be a new sentence
-        else if (!newText.empty() && std::isupper(newText[0])) {
-            // Add period if not already ending with punctuation
-            return previousText + ". " + newText;
-        } else {
-            return previousText + " " + newText;
-        }
-    } else {
-        // Previous text already ends with punctuation or space
-        return previousText + newText;
-    }
-}
-
 // Check if text contains the wake word
 static bool containsWakeWord(const std::string& text, const Settings& settings) {
     // Simple implementation: check if text starts with "jarvis"
@@ -255,6 +135,12 @@ int main() {
     } else {
         Logger::info("Loaded settings.json from current directory");
     }
+    
+    // Record the pipeline timeline for Perfetto / chrome://tracing
+    Trace::setThreadName("main");
+    if (settings.tracing.enabled) {
+        Trace::start(settings.tracing.maxEventsPerThread);
+    }
 
     // Initialize SDL2 for audio
     if (SDL_Init(SDL_INIT_AUDIO) < 0) {
@@ -263,21 +149,19 @@ int main() {
     }
 
     // Initialize audio manager
+    // Capture from the device unless a file or pipe source is configured
+    std::unique_ptr<AudioSource> audioSource = createFileAudioSource(settings.audioSource);
+    if (!audioSource) {
+        audioSource.reset(new SdlAudioSource(settings.audioDevice));
+    }
+    
     AudioManager audioManager(settings);
-    if (!audioManager.init()) {
+    if (!audioManager.init(std::move(audioSource))) {
         Logger::error("AudioManager initialization failed");
         SDL_Quit();
         return 1;
     }
 
-    // Initialize transcription engine
-    Transcription transcription(settings);
-    if (!transcription.init()) {
-        Logger::error("Transcription initialization failed");
-        SDL_Quit();
-        return 1;
-    }
-
     // Initialize keyboard simulator
     Keyboard keyboard;
 
@@ -304,6 +188,31 @@ int main() {
     }
 #endif
 
+    // Load the model last and in the background so hotkeys and capture work right away;
+    // anything recorded meanwhile is queued (or held by the main loop once the queue is
+    // full) and decoded once the model is ready
+    Transcription transcription(settings);
+    
+    // Everything that can be said in mouse mode: mode switches, key presses and mouse commands
+    CommandVocabulary commandVocabulary;
+    for (const auto* commands : {&settings.commands.mouseMode, &settings.commands.textMode,
+                                 &settings.commands.continuousMode, &settings.commands.exitContinuousMode,
+                                 &settings.commands.latencyReport}) {
+        commandVocabulary.phrases.insert(commandVocabulary.phrases.end(), commands->begin(), commands->end());
+    }
+    std::vector<std::string> mouseActions = Mouse::getActionPhrases();
+    commandVocabulary.phrases.insert(commandVocabulary.phrases.end(), mouseActions.begin(), mouseActions.end());
+    commandVocabulary.movementPhrases = Mouse::getMovementPhrases();
+    commandVocabulary.keyPrefixes = settings.commands.keyPress;
+    commandVocabulary.keyNames = keyboard.getKeyNames();
+    transcription.setCommandGrammar(commandVocabulary);
+    
+    if (!transcription.init()) {
+        Logger::error("Transcription initialization failed");
+        SDL_Quit();
+        return 1;
+    }
+
     // Current input mode and continuous mode status
     InputMode currentInputMode = TEXT_MODE;
     bool continuousModeActive = false;
@@ -317,11 +226,226 @@ int main() {
     // Buffer for continuous mode
     std::string continuousTextBuffer;
     
+    // A segment of the current push-to-talk recording has been typed, so the next
+    // part needs a space in front
+    bool recordingTextTyped = false;
+    
+    // Transcriptions in flight on the inference worker, oldest first
+    std::deque<PendingTranscription> pendingTranscriptions;
+    
+    // Cancels the current continuous session's chunks when continuous mode ends
+    CancellationToken continuousCancel;
+    
+    // Chunks taken from the audio manager wait here in capture order while the queue
+    // the oldest one routes to is full, so the main loop never blocks in submit()
+    std::deque<HeldChunk> heldChunks;
+    
     // Use commands from settings
     const std::vector<std::string>& MOUSE_MODE_COMMANDS = settings.commands.mouseMode;
     const std::vector<std::string>& TEXT_MODE_COMMANDS = settings.commands.textMode;
     const std::vector<std::string>& CONTINUOUS_MODE_COMMANDS = settings.commands.continuousMode;
     const std::vector<std::string>& EXIT_CONTINUOUS_MODE_COMMANDS = settings.commands.exitContinuousMode;
+    const std::vector<std::string>& LATENCY_REPORT_COMMANDS = settings.commands.latencyReport;
+    
+    // Per-stage latency from end of speech to output, dumped by voice command and at exit
+    LatencyTracker latencyTracker(settings.sampleRate);
+
+    // Continuous chunk queue health, logged with the latency report and at exit
+    auto logChunkQueueStats = [&]() {
+        ChunkQueueStats queue = audioManager.getChunkQueueStats();
+        Logger::info("Chunk queue: " + std::to_string(queue.depth) + " waiting (" +
+                     std::to_string(queue.queuedSeconds).substr(0, 5) + " s, oldest " +
+                     std::to_string(static_cast<int>(queue.oldestAgeMs)) + " ms), peak " +
+                     std::to_string(queue.peakDepth) + " chunk(s) / " +
+                     std::to_string(queue.peakQueuedSeconds).substr(0, 5) + " s, merged " +
+                     std::to_string(queue.mergedChunks) + ", sent to fast model " +
+                     std::to_string(queue.downgradedChunks) + ", dropped " +
+                     std::to_string(queue.droppedChunks) + " (" +
+                     std::to_string(queue.droppedSeconds).substr(0, 5) + " s)");
+    };
+
+    // Queue audio for transcription without waiting for the result
+    auto submitTranscription = [&](PendingTranscription::Kind kind, AudioChunk audio) {
+        PendingTranscription pending;
+        pending.kind = kind;
+        // Continuous chunks are decoded with the text that came before them as a prompt;
+        // mouse-mode commands go to the fast model when one is configured
+        bool continuousChunk = (kind == PendingTranscription::CONTINUOUS);
+        pending.result = transcription.submit(std::move(audio), continuousChunk, currentInputMode == MOUSE_MODE,
+                                              continuousChunk ? continuousCancel : CancellationToken());
+        pendingTranscriptions.push_back(std::move(pending));
+    };
+    
+    // Submit held chunks, oldest first, while their queues have room; true once nothing is held
+    auto submitHeldChunks = [&]() {
+        while (!heldChunks.empty() && transcription.canSubmit(heldChunks.front().audio, currentInputMode == MOUSE_MODE)) {
+            submitTranscription(heldChunks.front().kind, std::move(heldChunks.front().audio));
+            heldChunks.pop_front();
+        }
+        return heldChunks.empty();
+    };
+    
+    // A stopped push-to-talk recording goes in behind its held segments
+    auto submitRecording = [&]() {
+        Logger::info("Transcribing audio");
+        heldChunks.push_back(HeldChunk{PendingTranscription::PUSH_TO_TALK, audioManager.getRecording()});
+        if (!submitHeldChunks() && !transcription.isReady()) {
+            Logger::info("Model still loading: " + std::to_string(heldChunks.size()) +
+                         " chunk(s) held until its queue has room");
+        }
+    };
+    
+    // Continuous chunks still held when continuous mode ends are no longer wanted
+    auto dropHeldContinuousChunks = [&]() {
+        heldChunks.erase(std::remove_if(heldChunks.begin(), heldChunks.end(), [](const HeldChunk& held) {
+            return held.kind == PendingTranscription::CONTINUOUS;
+        }), heldChunks.end());
+    };
+    
+    // Act on a finished transcription: key commands, mode switches, typing or mouse control.
+    // Returns false if the result was dropped without producing any output.
+    auto actOnTranscription = [&](PendingTranscription::Kind kind, const TranscriptionResult& result,
+                                  ChunkTiming& timing) {
+        bool continuousChunk = (kind == PendingTranscription::CONTINUOUS);
+        
+        // Chunks still in flight when continuous mode ended are no longer wanted
+        if (result.cancelled || (continuousChunk && !continuousModeActive)) {
+            Logger::info("Discarding chunk transcribed after continuous mode ended");
+            return false;
+        }
+        
+        // Clean the transcription text
+        std::string transcribedText = cleanTranscription(result.text);
+        if (transcribedText.empty()) {
+            return false;
+        }
+        timing.postProcessed = ChunkTiming::Clock::now();
+        
+        Logger::info(std::string(continuousChunk ? "Continuous chunk transcribed" : "Transcription complete") +
+                     ": \"" + transcribedText + "\" (" + std::to_string(static_cast<int>(result.inferenceMs)) +
+                     " ms, queued " + std::to_string(static_cast<int>(result.queueMs)) + " ms)");
+        
+        // Continuous chunks are committed in capture order as context for the next one
+        if (continuousChunk) {
+            transcription.commitContext(result);
+        }
+        
+        // First check for key press commands
+        if (processText(transcribedText, voiceCommands, mouse, keyboard, settings)) {
+            return true;
+        }
+        
+        // If processText returns false, it might still be a wake word command
+        // that needs to be processed for mode switching
+        std::string normalizedText = normalizeText(transcribedText);
+        
+        if (containsAnyCommand(normalizedText, LATENCY_REPORT_COMMANDS)) {
+            latencyTracker.log();
+            logChunkQueueStats();
+            return true;
+        }
+        
+        if (continuousChunk) {
+            // Check for exit continuous mode command
+            if (containsAnyCommand(normalizedText, EXIT_CONTINUOUS_MODE_COMMANDS)) {
+                Logger::info("Exiting continuous mode");
+                continuousModeActive = false;
+                continuousCancel.cancel();
+                dropHeldContinuousChunks();
+                audioManager.stopRecording();
+                audioManager.setContinuousMode(false);
+                continuousTextBuffer.clear();
+                transcription.resetContext();
+            }
+            // Check for mode switch commands
+            else if (containsAnyCommand(normalizedText, MOUSE_MODE_COMMANDS)) {
+                // Check if we need to type out accumulated text before switching modes
+                bool wasInTextMode = (currentInputMode == TEXT_MODE);
+                
+                // Switch to mouse mode but stay in continuous mode
+                currentInputMode = MOUSE_MODE;
+                transcription.resetContext();
+                Logger::info("Switched to MOUSE MODE (continuous listening active)");
+                
+                // Type any accumulated text before switching to mouse mode
+                if (wasInTextMode && !continuousTextBuffer.empty()) {
+                    keyboard.typeText(continuousTextBuffer);
+                    continuousTextBuffer.clear();
+                }
+            }
+            else if (containsAnyCommand(normalizedText, TEXT_MODE_COMMANDS)) {
+                // Switch to text mode but stay in continuous mode
+                currentInputMode = TEXT_MODE;
+                transcription.resetContext();
+                Logger::info("Switched to TEXT MODE (continuous listening active)");
+            }
+            // Process based on current input mode
+            else if (currentInputMode == TEXT_MODE) {
+                // In text mode, accumulate text
+                continuousTextBuffer = mergeContinuousText(continuousTextBuffer, transcribedText);
+                
+                // Type when enough text has accumulated
+                if (continuousTextBuffer.length() > 150) {
+                    Logger::info("Typing accumulated text: \"" + continuousTextBuffer + "\"");
+                    keyboard.typeText(continuousTextBuffer);
+                    continuousTextBuffer.clear();
+                }
+            }
+            else { // MOUSE_MODE
+                // In mouse mode, process as mouse command
+                if (!mouse.processCommand(transcribedText)) {
+                    Logger::info("Unrecognized mouse command: " + transcribedText);
+                }
+            }
+            return true;
+        }
+        
+        // Check for mode switch commands
+        if (containsAnyCommand(normalizedText, CONTINUOUS_MODE_COMMANDS)) {
+            // Enable continuous mode
+            continuousModeActive = true;
+            continuousCancel = CancellationToken();
+            audioManager.startRecording();
+            audioManager.setContinuousMode(true);
+            continuousTextBuffer.clear();
+            transcription.resetContext();
+            Logger::info("Enabled CONTINUOUS MODE (current input: " + 
+                        std::string(currentInputMode == TEXT_MODE ? "TEXT" : "MOUSE") + ")");
+        } else if (containsAnyCommand(normalizedText, MOUSE_MODE_COMMANDS)) {
+            // Switch to mouse mode
+            currentInputMode = MOUSE_MODE;
+            Logger::info("Switched to MOUSE MODE");
+        } else if (containsAnyCommand(normalizedText, TEXT_MODE_COMMANDS)) {
+            // Switch to text mode
+            currentInputMode = TEXT_MODE;
+            Logger::info("Switched to TEXT MODE");
+        } else {
+            // Process based on current input mode
+            if (currentInputMode == TEXT_MODE) {
+                // Normal text input; parts of one recording are separated like words
+                bool recordingPart = (kind != PendingTranscription::CONTINUOUS);
+                keyboard.typeText(recordingPart && recordingTextTyped ? " " + transcribedText : transcribedText);
+                recordingTextTyped = (kind == PendingTranscription::PUSH_TO_TALK_SEGMENT);
+            } else { // MOUSE_MODE
+                // Process as mouse command
+                if (!mouse.processCommand(transcribedText)) {
+                    Logger::info("Unrecognized mouse command: " + transcribedText);
+                }
+            }
+        }
+        return true;
+    };
+    
+    // Continuous text is typed once enough has accumulated, so its output stage ends when
+    // the chunk has been merged into the buffer
+    auto handleTranscription = [&](PendingTranscription::Kind kind, const TranscriptionResult& result) {
+        TRACE_SCOPE("handleTranscription");
+        ChunkTiming timing = result.timing;
+        if (actOnTranscription(kind, result, timing)) {
+            timing.output = ChunkTiming::Clock::now();
+            latencyTracker.record(timing);
+        }
+    };
 
     Logger::info("TurboTalkText started");
     Logger::info("Press Ctrl+Shift+A to toggle recording");
@@ -395,6 +519,13 @@ int main() {
             }
         }
 
+        // Without a model nothing can be transcribed
+        if (transcription.hasFailed()) {
+            Logger::error("Whisper model failed to load: Shutting down application");
+            running = false;
+            continue;
+        }
+
         // Check for exit hotkey press
         if (hotkey.isExitHotkeyPressed()) {
             Logger::info("Exit hotkey pressed: Shutting down application");
@@ -412,63 +543,19 @@ int main() {
                 // If we were in continuous mode, just exit the continuous mode
                 if (continuousModeActive) {
                     continuousModeActive = false;
+                    continuousCancel.cancel();
+                    dropHeldContinuousChunks();
                     audioManager.setContinuousMode(false);
                     continuousTextBuffer.clear();
+                    transcription.resetContext();
                     Logger::info("Exited CONTINUOUS MODE");
                 } else {
-                    // Normal transcription for regular recording
-                    Logger::info("Transcribing audio");
-                    std::string transcribedText = transcription.transcribe(audioManager.getAudioData());
-                    
-                    // Clean the transcription text
-                    transcribedText = cleanTranscription(transcribedText);
-                    
-                    Logger::info("Transcription complete: \"" + transcribedText + "\"");
-                    
-                    // First check for key press commands
-                    bool isCommand = processText(transcribedText, voiceCommands, mouse, keyboard, settings);
-                    if (isCommand) {
-                        // Command was processed, continue to the next loop iteration
-                        hotkey.resetHotkeyPressed();
-                        continue;
-                    }
-                    
-                    // If processText returns false, it might still be a wake word command
-                    // that needs to be processed for mode switching
-                    std::string normalizedText = normalizeText(transcribedText);
-                    
-                    // Check for mode switch commands
-                    if (containsAnyCommand(normalizedText, CONTINUOUS_MODE_COMMANDS)) {
-                        // Enable continuous mode
-                        continuousModeActive = true;
-                        audioManager.startRecording();
-                        audioManager.setContinuousMode(true);
-                        continuousTextBuffer.clear();
-                        Logger::info("Enabled CONTINUOUS MODE (current input: " + 
-                                    std::string(currentInputMode == TEXT_MODE ? "TEXT" : "MOUSE") + ")");
-                    } else if (containsAnyCommand(normalizedText, MOUSE_MODE_COMMANDS)) {
-                        // Switch to mouse mode
-                        currentInputMode = MOUSE_MODE;
-                        Logger::info("Switched to MOUSE MODE");
-                    } else if (containsAnyCommand(normalizedText, TEXT_MODE_COMMANDS)) {
-                        // Switch to text mode
-                        currentInputMode = TEXT_MODE;
-                        Logger::info("Switched to TEXT MODE");
-                    } else {
-                        // Process based on current input mode
-                        if (currentInputMode == TEXT_MODE) {
-                            // Normal text input
-                            keyboard.typeText(transcribedText);
-                        } else { // MOUSE_MODE
-                            // Process as mouse command
-                            if (!mouse.processCommand(transcribedText)) {
-                                Logger::info("Unrecognized mouse command: " + transcribedText);
-                            }
-                        }
-                    }
+                    // Hand the recording to the inference worker
+                    submitRecording();
                 }
             } else {
                 Logger::info("Hotkey pressed: START recording");
+                recordingTextTyped = false;
                 audioManager.startRecording();
             }
             hotkey.resetHotkeyPressed();
@@ -478,138 +565,57 @@ int main() {
         if (audioManager.isRecording() && !continuousModeActive && audioManager.checkSilence()) {
             Logger::info("Silence detected while recording, STOP recording");
             audioManager.stopRecording();
-            Logger::info("Transcribing audio");
-            std::string transcribedText = transcription.transcribe(audioManager.getAudioData());
-            
-            // Clean the transcription text
-            transcribedText = cleanTranscription(transcribedText);
-            
-            Logger::info("Transcription complete: \"" + transcribedText + "\"");
-            
-            // First check for key press commands
-            bool isCommand = processText(transcribedText, voiceCommands, mouse, keyboard, settings);
-            if (isCommand) {
-                // Command was processed, continue to the next loop iteration
-                continue;
-            }
-            
-            // If processText returns false, it might still be a wake word command
-            // that needs to be processed for mode switching
-            std::string normalizedText = normalizeText(transcribedText);
-            
-            // Check for mode switch commands
-            if (containsAnyCommand(normalizedText, CONTINUOUS_MODE_COMMANDS)) {
-                // Enable continuous mode
-                continuousModeActive = true;
-                audioManager.startRecording();
-                audioManager.setContinuousMode(true);
-                continuousTextBuffer.clear();
-                Logger::info("Enabled CONTINUOUS MODE (current input: " + 
-                            std::string(currentInputMode == TEXT_MODE ? "TEXT" : "MOUSE") + ")");
-            } else if (containsAnyCommand(normalizedText, MOUSE_MODE_COMMANDS)) {
-                // Switch to mouse mode
-                currentInputMode = MOUSE_MODE;
-                Logger::info("Switched to MOUSE MODE");
-            } else if (containsAnyCommand(normalizedText, TEXT_MODE_COMMANDS)) {
-                // Switch to text mode
-                currentInputMode = TEXT_MODE;
-                Logger::info("Switched to TEXT MODE");
-            } else {
-                // Process based on current input mode
-                if (currentInputMode == TEXT_MODE) {
-                    // Normal text input
-                    keyboard.typeText(transcribedText);
-                } else { // MOUSE_MODE
-                    // Process as mouse command
-                    if (!mouse.processCommand(transcribedText)) {
-                        Logger::info("Unrecognized mouse command: " + transcribedText);
-                    }
-                }
+            submitRecording();
+        }
+        
+        // Decode finished sentences of a push-to-talk recording while the user keeps talking
+        if (audioManager.isRecording() && !continuousModeActive) {
+            while (submitHeldChunks() && audioManager.hasRecordingSegment()) {
+                heldChunks.push_back(HeldChunk{PendingTranscription::PUSH_TO_TALK_SEGMENT,
+                                               audioManager.takeRecordingSegment()});
+                Logger::info("Transcribing finished part of the recording");
             }
         }
         
-        // Handle continuous mode processing
+        // Mouse commands are short, so end their speech chunks sooner
+        audioManager.setCommandMode(currentInputMode == MOUSE_MODE);
+        
+        // Handle continuous mode processing: feed chunks while the worker has room
         if (continuousModeActive && audioManager.isRecording()) {
-            // Check if we have a new chunk of audio to process
-            if (audioManager.hasNewContinuousAudio()) {
-                std::vector<float> audioChunk = audioManager.getContinuousAudioChunk();
-                
-                if (!audioChunk.empty()) {
-                    Logger::info("Processing continuous audio chunk");
-                    std::string transcribedChunk = transcription.transcribe(audioChunk);
-                    
-                    if (!transcribedChunk.empty()) {
-                        // Clean the transcription text
-                        transcribedChunk = cleanTranscription(transcribedChunk);
-                        
-                        Logger::info("Continuous chunk transcribed: \"" + transcribedChunk + "\"");
-                        
-                        // First check for key press commands
-                        bool isCommand = processText(transcribedChunk, voiceCommands, mouse, keyboard, settings);
-                        if (isCommand) {
-                            // Command was processed, continue to the next loop iteration
-                            continue;
-                        }
-                        
-                        // If processText returns false, it might still be a wake word command
-                        // that needs to be processed for mode switching
-                        std::string normalizedChunk = normalizeText(transcribedChunk);
-                        
-                        // Check for exit continuous mode command
-                        if (containsAnyCommand(normalizedChunk, EXIT_CONTINUOUS_MODE_COMMANDS)) {
-                            Logger::info("Exiting continuous mode");
-                            continuousModeActive = false;
-                            audioManager.stopRecording();
-                            audioManager.setContinuousMode(false);
-                            continuousTextBuffer.clear();
-                        } 
-                        // Check for mode switch commands
-                        else if (containsAnyCommand(normalizedChunk, MOUSE_MODE_COMMANDS)) {
-                            // Check if we need to type out accumulated text before switching modes
-                            bool wasInTextMode = (currentInputMode == TEXT_MODE);
-                            
-                            // Switch to mouse mode but stay in continuous mode
-                            currentInputMode = MOUSE_MODE;
-                            Logger::info("Switched to MOUSE MODE (continuous listening active)");
-                            
-                            // Type any accumulated text before switching to mouse mode
-                            if (wasInTextMode && !continuousTextBuffer.empty()) {
-                                keyboard.typeText(continuousTextBuffer);
-                                continuousTextBuffer.clear();
-                            }
-                        } 
-                        else if (containsAnyCommand(normalizedChunk, TEXT_MODE_COMMANDS)) {
-                            // Switch to text mode but stay in continuous mode
-                            currentInputMode = TEXT_MODE;
-                            Logger::info("Switched to TEXT MODE (continuous listening active)");
-                        }
-                        // Process based on current input mode
-                        else if (currentInputMode == TEXT_MODE) {
-                            // In text mode, accumulate text
-                            continuousTextBuffer = mergeContinuousText(continuousTextBuffer, transcribedChunk);
-                            
-                            // Type when enough text has accumulated
-                            if (continuousTextBuffer.length() > 150) {
-                                Logger::info("Typing accumulated text: \"" + continuousTextBuffer + "\"");
-                                keyboard.typeText(continuousTextBuffer);
-                                continuousTextBuffer.clear();
-                            }
-                        } 
-                        else { // MOUSE_MODE
-                            // In mouse mode, process as mouse command
-                            if (!mouse.processCommand(transcribedChunk)) {
-                                Logger::info("Unrecognized mouse command: " + transcribedChunk);
-                            }
-                        }
-                    }
+            while (submitHeldChunks() && audioManager.hasNewContinuousAudio()) {
+                AudioChunk chunk = audioManager.getContinuousAudioChunk();
+                if (chunk.empty()) {
+                    break;
                 }
+                heldChunks.push_back(HeldChunk{PendingTranscription::CONTINUOUS, std::move(chunk)});
+                Logger::info("Processing continuous audio chunk");
             }
         }
+        
+        // Whatever is still held (e.g. a stopped recording) goes in once its queue has room
+        submitHeldChunks();
+        
+        // Dispatch finished transcriptions in the order they were captured
+        while (!pendingTranscriptions.empty() &&
+               pendingTranscriptions.front().result.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            PendingTranscription pending = std::move(pendingTranscriptions.front());
+            pendingTranscriptions.pop_front();
+            handleTranscription(pending.kind, pending.result.get());
+        }
 
         // Sleep to avoid high CPU usage
         Sleep(10);
     }
     Logger::info("No longer running, doing cleanup");
+    if (!heldChunks.empty()) {
+        Logger::info("Dropping " + std::to_string(heldChunks.size()) + " chunk(s) that never reached the queue");
+    }
+    transcription.logRouteStats();
+    latencyTracker.log();
+    logChunkQueueStats();
+    if (Trace::isEnabled()) {
+        Trace::writeJson(settings.tracing.outputPath);
+    }
 
     // Cleanup
     hotkey.unregisterHotkey();
@@ -0,0 +1,270 @@
+#include "mel_spectrogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+
+// Whisper's STFT parameters at 16 kHz
+static const int SAMPLE_RATE = 16000;
+static const int N_FFT = 400;
+static const int HOP = 160;
+static const int BINS = N_FFT / 2 + 1;                // 201 power-spectrum bins
+static const int BINS_PADDED = (BINS + 7) / 8 * 8;    // Rows padded to whole vectors
+static const int REFLECT = N_FFT / 2;                 // Reflection padding at the start
+static const size_t TAIL_PADDING = 30 * SAMPLE_RATE;  // Zero padding at the end
+static const float LOG_FLOOR = -10.0f;                // log10(1e-10), whisper's floor
+
+// Hann window and DFT basis, shared by every spectrogram. The basis is stored
+// sample-major so each sample updates all bins with one contiguous multiply-add,
+// which the compiler turns into vector instructions.
+struct StftTables {
+    float hann[N_FFT];
+    std::vector<float> cosBasis;  // N_FFT x BINS_PADDED
+    std::vector<float> sinBasis;
+
+    StftTables() : cosBasis(N_FFT * BINS_PADDED, 0.0f), sinBasis(N_FFT * BINS_PADDED, 0.0f) {
+        const double pi = 3.14159265358979323846;
+        for (int j = 0; j < N_FFT; j++) {
+            hann[j] = static_cast<float>(0.5 * (1.0 - std::cos(2.0 * pi * j / N_FFT)));
+            for (int k = 0; k < BINS; k++) {
+                double angle = 2.0 * pi * ((static_cast<long>(j) * k) % N_FFT) / N_FFT;
+                cosBasis[j * BINS_PADDED + k] = static_cast<float>(std::cos(angle));
+                sinBasis[j * BINS_PADDED + k] = static_cast<float>(-std::sin(angle));
+            }
+        }
+    }
+};
+
+static const StftTables& stftTables() {
+    static const StftTables tables;
+    return tables;
+}
+
+// Slaney mel scale, as used by librosa and the filters stored in whisper models
+static double hzToMel(double hz) {
+    const double fSp = 200.0 / 3.0;
+    const double minLogHz = 1000.0;
+    const double minLogMel = minLogHz / fSp;
+    const double logStep = std::log(6.4) / 27.0;
+    return hz < minLogHz ? hz / fSp : minLogMel + std::log(hz / minLogHz) / logStep;
+}
+
+static double melToHz(double mel) {
+    const double fSp = 200.0 / 3.0;
+    const double minLogHz = 1000.0;
+    const double minLogMel = minLogHz / fSp;
+    const double logStep = std::log(6.4) / 27.0;
+    return mel < minLogMel ? mel * fSp : minLogHz * std::exp(logStep * (mel - minLogMel));
+}
+
+MelSpectrogram::MelSpectrogram(int nMels)
+    : nMels(nMels > 0 ? nMels : 80),
+      fftReal(BINS_PADDED), fftImag(BINS_PADDED), windowed(N_FFT) {
+    // Triangular filters between nMels + 2 points evenly spaced on the mel scale
+    std::vector<double> melPoints(this->nMels + 2);
+    double melMax = hzToMel(SAMPLE_RATE / 2.0);
+    for (int i = 0; i < this->nMels + 2; i++) {
+        melPoints[i] = melToHz(melMax * i / (this->nMels + 1));
+    }
+
+    filters.assign(static_cast<size_t>(this->nMels) * BINS, 0.0f);
+    for (int m = 0; m < this->nMels; m++) {
+        double lower = melPoints[m];
+        double center = melPoints[m + 1];
+        double upper = melPoints[m + 2];
+        double norm = 2.0 / (upper - lower);
+        for (int k = 0; k < BINS; k++) {
+            double hz = static_cast<double>(k) * SAMPLE_RATE / N_FFT;
+            double weight = std::min((hz - lower) / (center - lower), (upper - hz) / (upper - center));
+            if (weight > 0.0) {
+                filters[m * BINS + k] = static_cast<float>(weight * norm);
+            }
+        }
+    }
+    setFilterRanges();
+}
+
+bool MelSpectrogram::loadModelFilters(const std::string& modelPath) {
+    // ggml model layout: magic, 11 int32 hyperparameters, then the mel filterbank as
+    // int32 n_mel, int32 n_fft and n_mel x n_fft float32 weights
+    std::ifstream file(modelPath, std::ios::binary);
+    uint32_t magic = 0;
+    int32_t hparams[11] = {};
+    int32_t fileMels = 0;
+    int32_t fileBins = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(hparams), sizeof(hparams));
+    file.read(reinterpret_cast<char*>(&fileMels), sizeof(fileMels));
+    file.read(reinterpret_cast<char*>(&fileBins), sizeof(fileBins));
+    if (!file || magic != 0x67676d6c || fileMels != nMels || fileBins != BINS) {
+        return false;
+    }
+
+    std::vector<float> weights(static_cast<size_t>(nMels) * BINS);
+    file.read(reinterpret_cast<char*>(weights.data()), static_cast<std::streamsize>(weights.size() * sizeof(float)));
+    if (!file) {
+        return false;
+    }
+    filters = std::move(weights);
+    setFilterRanges();
+    return true;
+}
+
+// Each band only sums the bins its triangle covers
+void MelSpectrogram::setFilterRanges() {
+    filterStart.assign(nMels, BINS);
+    filterEnd.assign(nMels, 0);
+    for (int m = 0; m < nMels; m++) {
+        for (int k = 0; k < BINS; k++) {
+            if (filters[m * BINS + k] != 0.0f) {
+                filterStart[m] = std::min(filterStart[m], k);
+                filterEnd[m] = k + 1;
+            }
+        }
+    }
+}
+
+void MelSpectrogram::reset() {
+    padded.clear();
+    paddedOffset = 0;
+    reflected = false;
+    logFrames.clear();
+    frames = 0;
+    samples = 0;
+}
+
+void MelSpectrogram::release() {
+    reset();
+    std::vector<float>().swap(padded);
+    std::vector<float>().swap(logFrames);
+}
+
+void MelSpectrogram::push(const float* input, size_t count) {
+    padded.insert(padded.end(), input, input + count);
+    samples += count;
+
+    // Whisper mirrors samples 1..200 in front of the clip, so wait until they exist
+    if (!reflected) {
+        if (samples <= static_cast<size_t>(REFLECT)) {
+            return;
+        }
+        padded.insert(padded.begin(), padded.begin() + 1, padded.begin() + 1 + REFLECT);
+        std::reverse(padded.begin(), padded.begin() + REFLECT);
+        reflected = true;
+    }
+
+    computeFrames(false);
+}
+
+MelFrames MelSpectrogram::finish() {
+    MelFrames mel;
+    if (!reflected) {
+        reset();
+        return mel;
+    }
+    computeFrames(true);
+
+    // Clamp to 8 below the loudest value and scale, over the whole padded clip
+    float maxValue = LOG_FLOOR;
+    for (float value : logFrames) {
+        maxValue = std::max(maxValue, value);
+    }
+    float floorValue = maxValue - 8.0f;
+
+    mel.nMels = nMels;
+    mel.nFrames = static_cast<int>(frames);
+    mel.data.resize(frames * nMels);
+    for (size_t t = 0; t < frames; t++) {
+        const float* frame = &logFrames[t * nMels];
+        for (int m = 0; m < nMels; m++) {
+            mel.data[m * frames + t] = (std::max(frame[m], floorValue) + 4.0f) / 4.0f;
+        }
+    }
+
+    reset();
+    return mel;
+}
+
+size_t MelSpectrogram::sampleCount() const {
+    return samples;
+}
+
+int MelSpectrogram::melCount() const {
+    return nMels;
+}
+
+size_t MelSpectrogram::finishedBytes() const {
+    size_t totalFrames = (samples + TAIL_PADDING) / HOP;
+    return 2 * totalFrames * static_cast<size_t>(nMels) * sizeof(float) + padded.capacity() * sizeof(float);
+}
+
+// Compute the frames the buffered signal completes; the final pass also covers the
+// frames that run into the zero padding, exactly as many as whisper produces
+void MelSpectrogram::computeFrames(bool final) {
+    const size_t signalEnd = samples + REFLECT;  // Padded-signal length before the tail
+    size_t lastFftFrame = signalEnd / HOP + 1;
+    size_t totalFrames = (samples + TAIL_PADDING) / HOP;
+
+    while (true) {
+        size_t offset = frames * HOP;
+        size_t available = signalEnd > offset ? std::min<size_t>(N_FFT, signalEnd - offset) : 0;
+        if (!final && available < static_cast<size_t>(N_FFT)) {
+            break;
+        }
+        if (final && (frames >= totalFrames || frames >= lastFftFrame)) {
+            break;
+        }
+
+        logFrames.resize((frames + 1) * nMels);
+        computeFrame(padded.data() + (offset - paddedOffset), available, &logFrames[frames * nMels]);
+        frames++;
+    }
+
+    if (final) {
+        // Frames entirely inside the zero padding have no energy
+        logFrames.resize(totalFrames * nMels, LOG_FLOOR);
+        frames = std::max(frames, totalFrames);
+        return;
+    }
+
+    // Drop the part of the signal no future frame will read
+    size_t consumed = frames * HOP - paddedOffset;
+    if (consumed >= static_cast<size_t>(SAMPLE_RATE)) {
+        padded.erase(padded.begin(), padded.begin() + consumed);
+        paddedOffset += consumed;
+    }
+}
+
+// One STFT frame: window, DFT power spectrum, mel filters, log10
+void MelSpectrogram::computeFrame(const float* window, size_t available, float* out) {
+    const StftTables& tables = stftTables();
+    for (size_t j = 0; j < static_cast<size_t>(N_FFT); j++) {
+        windowed[j] = j < available ? tables.hann[j] * window[j] : 0.0f;
+    }
+
+    std::fill(fftReal.begin(), fftReal.end(), 0.0f);
+    std::fill(fftImag.begin(), fftImag.end(), 0.0f);
+    float* real = fftReal.data();
+    float* imag = fftImag.data();
+    for (int j = 0; j < N_FFT; j++) {
+        const float x = windowed[j];
+        const float* cosRow = &tables.cosBasis[j * BINS_PADDED];
+        const float* sinRow = &tables.sinBasis[j * BINS_PADDED];
+        for (int k = 0; k < BINS_PADDED; k++) {
+            real[k] += x * cosRow[k];
+            imag[k] += x * sinRow[k];
+        }
+    }
+    for (int k = 0; k < BINS; k++) {
+        real[k] = real[k] * real[k] + imag[k] * imag[k];
+    }
+
+    for (int m = 0; m < nMels; m++) {
+        const float* filter = &filters[m * BINS];
+        double sum = 0.0;
+        for (int k = filterStart[m]; k < filterEnd[m]; k++) {
+            sum += filter[k] * real[k];
+        }
+        out[m] = static_cast<float>(std::log10(std::max(sum, 1e-10)));
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "audio_chunk.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Whisper-compatible log-mel spectrogram, computed frame by frame while samples arrive
+// so only normalization is left when the clip ends. Matches whisper.cpp's own
+// extraction: 400-sample Hann window, 160-sample hop, 200-sample reflection at the
+// start, 30 s of zero padding at the end, Slaney mel filters, log10 clamped to max - 8.
+class MelSpectrogram {
+public:
+    explicit MelSpectrogram(int nMels = 80);
+
+    // Use the filterbank stored in a whisper ggml model file instead of the computed
+    // one, so the bands are exactly those whisper_pcm_to_mel applies. False, with the
+    // filters unchanged, if the file can't be read or has a different band count.
+    bool loadModelFilters(const std::string& modelPath);
+
+    // Start a new clip
+    void reset();
+
+    // Start a new clip and give back the memory the last one used
+    void release();
+
+    // Append 16 kHz mono samples and compute every frame they complete
+    void push(const float* samples, size_t count);
+
+    // Finish the clip: compute the trailing frames, normalize, and reset for the next
+    // clip. Empty if the clip was too short for whisper's reflection padding.
+    MelFrames finish();
+
+    size_t sampleCount() const;
+    int melCount() const;
+
+    // Memory the clip's spectrogram takes once finish() has run, in bytes: the log
+    // frames and their normalized copy, both covering the 30 s of padding
+    size_t finishedBytes() const;
+
+private:
+    void setFilterRanges();
+    void computeFrames(bool final);
+    void computeFrame(const float* window, size_t available, float* out);
+
+    int nMels;
+    std::vector<float> filters;       // nMels x bins, Slaney-normalized triangles
+    std::vector<int> filterStart;     // First and one-past-last non-zero bin per mel band
+    std::vector<int> filterEnd;
+
+    std::vector<float> padded;        // Padded signal from paddedOffset on
+    size_t paddedOffset = 0;          // Padded-signal index of padded[0]
+    bool reflected = false;           // Start padding is in place
+    std::vector<float> logFrames;     // Un-normalized log10 values, frame-major
+    size_t frames = 0;
+    size_t samples = 0;
+    std::vector<float> fftReal;       // Scratch for one frame
+    std::vector<float> fftImag;
+    std::vector<float> windowed;
+};
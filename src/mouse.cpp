@@ -1,9 +1,11 @@
 #include "mouse.h"
 #include "logger.h"
+#include "trace.h"
 #include <algorithm>
 #include <cctype>
 #include <regex>
 #include <sstream>
+#include <vector>
 
 // Helper function to normalize text for command matching (static to limit scope to this file)
 static std::string normalizeText(const std::string& input) {
@@ -38,6 +40,31 @@ static bool extractNumber(const std::string& input, int& number) {
     return false;
 }
 
+// Simple command words to look for
+static const std::vector<std::string> UP_COMMANDS = {"up", "upward", "move up", "go up"};
+static const std::vector<std::string> DOWN_COMMANDS = {"down", "downward", "move down", "go down"};
+static const std::vector<std::string> LEFT_COMMANDS = {"left", "move left", "go left"};
+static const std::vector<std::string> RIGHT_COMMANDS = {"right", "move right", "go right"};
+static const std::vector<std::string> FASTER_COMMANDS = {"faster", "speed up", "increase speed"};
+static const std::vector<std::string> SLOWER_COMMANDS = {"slower", "slow down", "decrease speed"};
+static const std::vector<std::string> CLICK_COMMANDS = {"click", "right click", "double click"};
+
+std::vector<std::string> Mouse::getMovementPhrases() {
+    std::vector<std::string> phrases;
+    for (const auto* commands : {&UP_COMMANDS, &DOWN_COMMANDS, &LEFT_COMMANDS, &RIGHT_COMMANDS}) {
+        phrases.insert(phrases.end(), commands->begin(), commands->end());
+    }
+    return phrases;
+}
+
+std::vector<std::string> Mouse::getActionPhrases() {
+    std::vector<std::string> phrases;
+    for (const auto* commands : {&FASTER_COMMANDS, &SLOWER_COMMANDS, &CLICK_COMMANDS}) {
+        phrases.insert(phrases.end(), commands->begin(), commands->end());
+    }
+    return phrases;
+}
+
 void Mouse::moveRelative(int dx, int dy) {
     // Get current mouse position
     POINT currentPos;
@@ -68,17 +95,10 @@ void Mouse::setMovementSpeed(int speed) {
 }
 
 bool Mouse::processCommand(const std::string& command) {
+    TRACE_SCOPE("Mouse::processCommand");
     // Normalize the command for more flexible matching
     std::string normalizedCommand = normalizeText(command);
     
-    // Simple command words to look for
-    const std::string UP_COMMANDS[] = {"up", "upward", "move up", "go up"};
-    const std::string DOWN_COMMANDS[] = {"down", "downward", "move down", "go down"};
-    const std::string LEFT_COMMANDS[] = {"left", "move left", "go left"};
-    const std::string RIGHT_COMMANDS[] = {"right", "move right", "go right"};
-    const std::string FASTER_COMMANDS[] = {"faster", "speed up", "increase speed"};
-    const std::string SLOWER_COMMANDS[] = {"slower", "slow down", "decrease speed"};
-    
     // Try to extract a numeric value for precise movement
     int pixels = 0;
     bool hasPixelValue = extractNumber(normalizedCommand, pixels);
@@ -3,6 +3,7 @@
 
 #include <windows.h>
 #include <string>
+#include <vector>
 
 class Mouse {
 public:
@@ -18,6 +19,11 @@ public:
     // Process a command and move the mouse accordingly
     bool processCommand(const std::string& command);
     
+    // Phrases processCommand understands: movements (which may be followed by a
+    // pixel count) and everything else
+    static std::vector<std::string> getMovementPhrases();
+    static std::vector<std::string> getActionPhrases();
+    
 private:
     int movementSpeed = 20; // Default movement speed in pixels
 };
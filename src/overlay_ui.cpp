@@ -1,5 +1,6 @@
 #include "overlay_ui.h"
 #include "logger.h"
+#include "trace.h"
 #include <windows.h>
 #include <windowsx.h> // For GET_X_LPARAM and GET_Y_LPARAM
 #include <stdexcept>
@@ -283,6 +284,7 @@ bool OverlayUI::isMinimized() const {
 
 // Render the overlay
 void OverlayUI::render() {
+    TRACE_SCOPE("OverlayUI::render");
     if (!hwnd) return;
     
     // Get device context
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+// Lock-free single-producer/single-consumer ring buffer for audio samples.
+// Storage is allocated once in the constructor, so neither write() nor read()
+// ever allocates, locks or blocks. Exactly one thread may call write() and
+// exactly one (other) thread may call read().
+template <typename T>
+class SpscRingBuffer {
+public:
+    explicit SpscRingBuffer(size_t minCapacity) {
+        // Round capacity up to a power of two so positions can be masked
+        size_t capacity = 1;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        buffer.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t capacity() const {
+        return buffer.size();
+    }
+
+    // Number of samples ready to be read
+    size_t available() const {
+        return writePos.load(std::memory_order_acquire) - readPos.load(std::memory_order_acquire);
+    }
+
+    // Producer side: copy up to count samples in, returns how many fit
+    size_t write(const T* data, size_t count) {
+        const size_t head = writePos.load(std::memory_order_relaxed);
+        const size_t tail = readPos.load(std::memory_order_acquire);
+        const size_t toWrite = std::min(count, buffer.size() - (head - tail));
+
+        const size_t start = head & mask;
+        const size_t firstPart = std::min(toWrite, buffer.size() - start);
+        std::memcpy(buffer.data() + start, data, firstPart * sizeof(T));
+        std::memcpy(buffer.data(), data + firstPart, (toWrite - firstPart) * sizeof(T));
+
+        writePos.store(head + toWrite, std::memory_order_release);
+        return toWrite;
+    }
+
+    // Consumer side: copy up to maxCount samples out, returns how many were read
+    size_t read(T* out, size_t maxCount) {
+        const size_t tail = readPos.load(std::memory_order_relaxed);
+        const size_t head = writePos.load(std::memory_order_acquire);
+        const size_t toRead = std::min(maxCount, head - tail);
+
+        const size_t start = tail & mask;
+        const size_t firstPart = std::min(toRead, buffer.size() - start);
+        std::memcpy(out, buffer.data() + start, firstPart * sizeof(T));
+        std::memcpy(out + firstPart, buffer.data(), (toRead - firstPart) * sizeof(T));
+
+        readPos.store(tail + toRead, std::memory_order_release);
+        return toRead;
+    }
+
+private:
+    std::vector<T> buffer;
+    size_t mask = 0;
+
+    // Monotonic positions; kept on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<size_t> writePos{0};
+    alignas(64) std::atomic<size_t> readPos{0};
+};
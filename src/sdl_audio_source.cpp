@@ -0,0 +1,99 @@
+#include "sdl_audio_source.h"
+#include "logger.h"
+
+SdlAudioSource::SdlAudioSource(const std::string& deviceName) : deviceName(deviceName) {
+    SDL_zero(desiredSpec);
+    SDL_zero(obtainedSpec);
+}
+
+SdlAudioSource::~SdlAudioSource() {
+    close();
+}
+
+bool SdlAudioSource::open(int sampleRate, AudioSink* audioSink) {
+    sink = audioSink;
+
+    // Initialize desired audio spec
+    desiredSpec.freq = sampleRate;
+    desiredSpec.format = AUDIO_F32;
+    desiredSpec.channels = 1;
+    desiredSpec.samples = 1024; // Buffer size
+    desiredSpec.callback = SdlAudioSource::audioCallback;
+    desiredSpec.userdata = this;
+
+    // List all available audio input devices
+    int numDevices = SDL_GetNumAudioDevices(1); // 1 indicates capture devices
+    Logger::info("Available audio input devices:");
+    for (int i = 0; i < numDevices; i++) {
+        const char* name = SDL_GetAudioDeviceName(i, 1);
+        Logger::info(std::to_string(i) + ": " + name);
+    }
+
+    // Determine which device to use
+    std::string deviceToUse = deviceName;
+    if (deviceToUse.empty() && numDevices > 0) {
+        // If the device setting is empty, use the first available
+        deviceToUse = SDL_GetAudioDeviceName(0, 1);
+        Logger::info("Using first available device: " + deviceToUse);
+    }
+
+    // If the device is "default", pass NULL to use the system's default device
+    const char* name = (deviceToUse == "default") ? NULL : deviceToUse.c_str();
+    Logger::info("Opening audio device: " + std::string(name ? name : "default"));
+
+    // Attempt to open the audio device
+    deviceId = SDL_OpenAudioDevice(name, 1, &desiredSpec, &obtainedSpec, 0);
+    if (deviceId == 0) {
+        // If it fails, log the error and list devices again for reference
+        Logger::error("Failed to open audio device: " + std::string(SDL_GetError()));
+        Logger::error("Available audio input devices:");
+        for (int i = 0; i < numDevices; i++) {
+            const char* deviceListName = SDL_GetAudioDeviceName(i, 1);
+            Logger::error(std::to_string(i) + ": " + deviceListName);
+        }
+        return false;
+    }
+
+    deviceName = deviceToUse;
+    Logger::info("Audio device opened successfully");
+    Logger::info("Sample rate: " + std::to_string(obtainedSpec.freq));
+    Logger::info("Channels: " + std::to_string(obtainedSpec.channels));
+    Logger::info("Format: " + std::to_string(obtainedSpec.format));
+    Logger::info("Samples per chunk: " + std::to_string(obtainedSpec.samples));
+    return true;
+}
+
+void SdlAudioSource::start() {
+    SDL_PauseAudioDevice(deviceId, 0);
+}
+
+void SdlAudioSource::stop() {
+    // Once this returns SDL guarantees the callback is no longer running
+    SDL_PauseAudioDevice(deviceId, 1);
+}
+
+void SdlAudioSource::close() {
+    if (deviceId != 0) {
+        SDL_CloseAudioDevice(deviceId);
+        deviceId = 0;
+    }
+}
+
+int SdlAudioSource::blockSize() const {
+    return obtainedSpec.samples > 0 ? obtainedSpec.samples : 1024;
+}
+
+bool SdlAudioSource::isRealtime() const {
+    return true;
+}
+
+std::string SdlAudioSource::describe() const {
+    return "audio device '" + (deviceName.empty() ? std::string("default") : deviceName) + "'";
+}
+
+// Runs on SDL's audio thread: hand the samples straight to the sink
+void SdlAudioSource::audioCallback(void* userdata, Uint8* stream, int len) {
+    SdlAudioSource* source = static_cast<SdlAudioSource*>(userdata);
+    const float* samples = reinterpret_cast<const float*>(stream);
+    source->sink->pushRealtime(samples, len / sizeof(float));
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "audio_source.h"
+#include <SDL2/SDL.h>
+#include <string>
+
+// Live capture from an SDL audio input device
+class SdlAudioSource : public AudioSource {
+public:
+    // Empty name picks the first device, "default" the system default
+    explicit SdlAudioSource(const std::string& deviceName);
+    ~SdlAudioSource() override;
+
+    bool open(int sampleRate, AudioSink* sink) override;
+    void start() override;
+    void stop() override;
+    void close() override;
+    int blockSize() const override;
+    bool isRealtime() const override;
+    std::string describe() const override;
+
+private:
+    static void audioCallback(void* userdata, Uint8* stream, int len);
+
+    std::string deviceName;
+    SDL_AudioDeviceID deviceId = 0;
+    SDL_AudioSpec desiredSpec;
+    SDL_AudioSpec obtainedSpec;
+    AudioSink* sink = nullptr;
+};
@@ -4,6 +4,12 @@
 #include <iostream>
 
 Settings::Settings() {
+    // Default capture ring buffer size between the audio callback and processing thread
+    ringBufferMs = 4000;
+    
+    // Default to live capture from the audio device
+    audioSource = "device";
+    
     // Default voice commands
     commands.mouseMode = {
         "jarvis move the mouse", "jarvis move mouse", "move the mouse", 
@@ -29,13 +35,102 @@ Settings::Settings() {
         "jarvis press", "jarvis push", "jarvis key"
     };
     
+    commands.latencyReport = {
+        "jarvis latency report", "jarvis show latency"
+    };
+    
     // Default speech detection settings
     speechDetection.threshold = 0.02f;
     speechDetection.minSilenceMs = 1000;
+    speechDetection.commandMinSilenceMs = 0; // Same as minSilenceMs
     speechDetection.maxChunkSec = 15;
+    speechDetection.splitSearchMs = 1000;
+    speechDetection.splitOverlapMs = 100;
     speechDetection.preSpeechBufferMs = 500;
+    speechDetection.maxZeroCrossingRate = 0.0f; // Disabled
     speechDetection.enabled = true;
     
+    // Default capture buffer limits (64 MB is ~17 minutes at 16 kHz)
+    capture.maxMemoryMb = 64;
+    capture.spillToDisk = false;
+    capture.maxSpillMb = 1024;
+    capture.spillDir = "";
+    
+    // Default push-to-talk pipelining: cut at pauses well short of the auto-stop silence
+    pushToTalkPipeline.enabled = true;
+    pushToTalkPipeline.pauseMs = 500;
+    pushToTalkPipeline.minSegmentSec = 2.0f;
+    
+    // Default continuous chunk queue limits
+    chunkQueue.maxQueuedSec = 20.0f;
+    chunkQueue.policy = "merge";
+    chunkQueue.maxMergedSec = 28.0f;
+    chunkQueue.warnAgeSec = 5.0f;
+    
+    // Default tracing: off, written to the working directory
+    tracing.enabled = false;
+    tracing.outputPath = "turbotalk_trace.json";
+    tracing.maxEventsPerThread = 65536;
+    
+    // Default transcription worker queue limit
+    maxQueuedJobs = 4;
+    parallelDecoders = 1;
+    warmup = true;
+    
+    // Default dynamic audio context (disabled: always encode the full 30 s window)
+    dynamicAudioCtx.enabled = false;
+    dynamicAudioCtx.granularity = 64;
+    dynamicAudioCtx.marginMs = 1000;
+    dynamicAudioCtx.fallbackLogprob = -1.0f;
+    
+    // Default prompt context for continuous mode
+    promptContext.enabled = false;
+    promptContext.maxTokens = 64;
+    
+    // Default adaptive decoding thresholds (match whisper's own fallback heuristics)
+    adaptiveDecoding.enabled = false;
+    adaptiveDecoding.logprobThreshold = -1.0f;
+    adaptiveDecoding.compressionRatioThreshold = 2.4f;
+    adaptiveDecoding.temperatureIncrement = 0.2f;
+    adaptiveDecoding.latencyBudgetMs = 2000;
+    
+    // Default fast model routing (disabled until a model path is set)
+    fastModel.modelPath = "";
+    fastModel.maxUtteranceSec = 3.0f;
+    fastModel.useForMouseMode = true;
+    fastModel.decoders = 1;
+    
+    // Default command grammar (whisper's own default penalty)
+    commandGrammar.enabled = true;
+    commandGrammar.penalty = 100.0f;
+    
+    // Default incremental mel (off: whisper computes the spectrogram itself)
+    incrementalMel.enabled = false;
+    incrementalMel.nMels = 80;
+    
+    // Default speech gate; frames count as voiced by the speech detection threshold
+    speechGate.enabled = true;
+    speechGate.minRms = 0.002f;
+    speechGate.minVoicedMs = 120;
+    speechGate.minVoicedRatio = 0.02f;
+    speechGate.noSpeechThreshold = 0.6f;
+    speechGate.logprobThreshold = -1.0f;
+    speechGate.earlyStopThreshold = 0.9f;
+    
+    // Default batching of short queued utterances
+    batching.enabled = true;
+    batching.maxUtteranceSec = 5.0f;
+    batching.maxBatchSec = 24.0f;
+    batching.gapMs = 1000;
+    batching.maxUtterances = 4;
+    
+    // Default splitting of long push-to-talk recordings (needs parallel_decoders > 1)
+    parallelSplit.enabled = true;
+    parallelSplit.minRecordingSec = 12.0f;
+    parallelSplit.minWindowSec = 6.0f;
+    parallelSplit.maxWindowSec = 28.0f;
+    parallelSplit.searchMs = 1500;
+    
     // Default UI settings
     ui.enabled = true;
     ui.style = "circle";
@@ -58,6 +153,12 @@ bool Settings::load(const std::string& filename) {
     sampleRate = json["audio"]["sample_rate"].get<int>();
     silenceThreshold = json["audio"]["silence_threshold"].get<float>();
     silenceDurationMs = json["audio"]["silence_duration_ms"].get<int>();
+    if (json["audio"].contains("ring_buffer_ms")) {
+        ringBufferMs = json["audio"]["ring_buffer_ms"].get<int>();
+    }
+    if (json["audio"].contains("source")) {
+        audioSource = json["audio"]["source"].get<std::string>();
+    }
     
     // Load speech detection settings if they exist
     if (json.contains("speech_detection")) {
@@ -69,14 +170,30 @@ bool Settings::load(const std::string& filename) {
             speechDetection.minSilenceMs = json["speech_detection"]["min_silence_ms"].get<int>();
         }
         
+        if (json["speech_detection"].contains("command_min_silence_ms")) {
+            speechDetection.commandMinSilenceMs = json["speech_detection"]["command_min_silence_ms"].get<int>();
+        }
+        
         if (json["speech_detection"].contains("max_chunk_sec")) {
             speechDetection.maxChunkSec = json["speech_detection"]["max_chunk_sec"].get<int>();
         }
         
+        if (json["speech_detection"].contains("split_search_ms")) {
+            speechDetection.splitSearchMs = json["speech_detection"]["split_search_ms"].get<int>();
+        }
+        
+        if (json["speech_detection"].contains("split_overlap_ms")) {
+            speechDetection.splitOverlapMs = json["speech_detection"]["split_overlap_ms"].get<int>();
+        }
+        
         if (json["speech_detection"].contains("pre_speech_buffer_ms")) {
             speechDetection.preSpeechBufferMs = json["speech_detection"]["pre_speech_buffer_ms"].get<int>();
         }
         
+        if (json["speech_detection"].contains("max_zero_crossing_rate")) {
+            speechDetection.maxZeroCrossingRate = json["speech_detection"]["max_zero_crossing_rate"].get<float>();
+        }
+        
         if (json["speech_detection"].contains("enabled")) {
             speechDetection.enabled = json["speech_detection"]["enabled"].get<bool>();
         }
@@ -88,12 +205,224 @@ bool Settings::load(const std::string& filename) {
         Logger::info("Default max chunk: " + std::to_string(speechDetection.maxChunkSec) + "s");
     }
 
+    // Load capture buffer limits if they exist
+    if (json.contains("capture")) {
+        if (json["capture"].contains("max_memory_mb")) {
+            capture.maxMemoryMb = json["capture"]["max_memory_mb"].get<int>();
+        }
+        
+        if (json["capture"].contains("spill_to_disk")) {
+            capture.spillToDisk = json["capture"]["spill_to_disk"].get<bool>();
+        }
+        
+        if (json["capture"].contains("max_spill_mb")) {
+            capture.maxSpillMb = json["capture"]["max_spill_mb"].get<int>();
+        }
+        
+        if (json["capture"].contains("spill_dir")) {
+            capture.spillDir = json["capture"]["spill_dir"].get<std::string>();
+        }
+    }
+
+    // Load push-to-talk pipelining settings if they exist
+    if (json.contains("push_to_talk_pipeline")) {
+        if (json["push_to_talk_pipeline"].contains("enabled")) {
+            pushToTalkPipeline.enabled = json["push_to_talk_pipeline"]["enabled"].get<bool>();
+        }
+        
+        if (json["push_to_talk_pipeline"].contains("pause_ms")) {
+            pushToTalkPipeline.pauseMs = json["push_to_talk_pipeline"]["pause_ms"].get<int>();
+        }
+        
+        if (json["push_to_talk_pipeline"].contains("min_segment_sec")) {
+            pushToTalkPipeline.minSegmentSec = json["push_to_talk_pipeline"]["min_segment_sec"].get<float>();
+        }
+    }
+
+    // Load continuous chunk queue limits if they exist
+    if (json.contains("chunk_queue")) {
+        if (json["chunk_queue"].contains("max_queued_sec")) {
+            chunkQueue.maxQueuedSec = json["chunk_queue"]["max_queued_sec"].get<float>();
+        }
+        
+        if (json["chunk_queue"].contains("policy")) {
+            chunkQueue.policy = json["chunk_queue"]["policy"].get<std::string>();
+        }
+        
+        if (json["chunk_queue"].contains("max_merged_sec")) {
+            chunkQueue.maxMergedSec = json["chunk_queue"]["max_merged_sec"].get<float>();
+        }
+        
+        if (json["chunk_queue"].contains("warn_age_sec")) {
+            chunkQueue.warnAgeSec = json["chunk_queue"]["warn_age_sec"].get<float>();
+        }
+    }
+
+    // Load tracing settings if they exist
+    if (json.contains("tracing")) {
+        if (json["tracing"].contains("enabled")) {
+            tracing.enabled = json["tracing"]["enabled"].get<bool>();
+        }
+        
+        if (json["tracing"].contains("output_path")) {
+            tracing.outputPath = json["tracing"]["output_path"].get<std::string>();
+        }
+        
+        if (json["tracing"].contains("max_events_per_thread")) {
+            tracing.maxEventsPerThread = json["tracing"]["max_events_per_thread"].get<int>();
+        }
+    }
+
     // Load whisper settings
     modelPath = json["whisper"]["model_path"].get<std::string>();
     language = json["whisper"]["language"].get<std::string>();
     translate = json["whisper"]["translate"].get<bool>();
     beamSize = json["whisper"]["beam_size"].get<int>();
     threads = json["whisper"]["threads"].get<int>();
+    if (json["whisper"].contains("max_queued_jobs")) {
+        maxQueuedJobs = json["whisper"]["max_queued_jobs"].get<int>();
+    }
+    if (json["whisper"].contains("parallel_decoders")) {
+        parallelDecoders = json["whisper"]["parallel_decoders"].get<int>();
+    }
+    if (json["whisper"].contains("warmup")) {
+        warmup = json["whisper"]["warmup"].get<bool>();
+    }
+    if (json["whisper"].contains("dynamic_audio_ctx")) {
+        const auto& audioCtx = json["whisper"]["dynamic_audio_ctx"];
+        if (audioCtx.contains("enabled")) {
+            dynamicAudioCtx.enabled = audioCtx["enabled"].get<bool>();
+        }
+        if (audioCtx.contains("granularity")) {
+            dynamicAudioCtx.granularity = audioCtx["granularity"].get<int>();
+        }
+        if (audioCtx.contains("margin_ms")) {
+            dynamicAudioCtx.marginMs = audioCtx["margin_ms"].get<int>();
+        }
+        if (audioCtx.contains("fallback_logprob")) {
+            dynamicAudioCtx.fallbackLogprob = audioCtx["fallback_logprob"].get<float>();
+        }
+    }
+    if (json["whisper"].contains("prompt_context")) {
+        const auto& prompt = json["whisper"]["prompt_context"];
+        if (prompt.contains("enabled")) {
+            promptContext.enabled = prompt["enabled"].get<bool>();
+        }
+        if (prompt.contains("max_tokens")) {
+            promptContext.maxTokens = prompt["max_tokens"].get<int>();
+        }
+    }
+    if (json["whisper"].contains("adaptive_decoding")) {
+        const auto& adaptive = json["whisper"]["adaptive_decoding"];
+        if (adaptive.contains("enabled")) {
+            adaptiveDecoding.enabled = adaptive["enabled"].get<bool>();
+        }
+        if (adaptive.contains("logprob_threshold")) {
+            adaptiveDecoding.logprobThreshold = adaptive["logprob_threshold"].get<float>();
+        }
+        if (adaptive.contains("compression_ratio_threshold")) {
+            adaptiveDecoding.compressionRatioThreshold = adaptive["compression_ratio_threshold"].get<float>();
+        }
+        if (adaptive.contains("temperature_increment")) {
+            adaptiveDecoding.temperatureIncrement = adaptive["temperature_increment"].get<float>();
+        }
+        if (adaptive.contains("latency_budget_ms")) {
+            adaptiveDecoding.latencyBudgetMs = adaptive["latency_budget_ms"].get<int>();
+        }
+    }
+    if (json["whisper"].contains("fast_model")) {
+        const auto& fast = json["whisper"]["fast_model"];
+        if (fast.contains("model_path")) {
+            fastModel.modelPath = fast["model_path"].get<std::string>();
+        }
+        if (fast.contains("max_utterance_sec")) {
+            fastModel.maxUtteranceSec = fast["max_utterance_sec"].get<float>();
+        }
+        if (fast.contains("use_for_mouse_mode")) {
+            fastModel.useForMouseMode = fast["use_for_mouse_mode"].get<bool>();
+        }
+        if (fast.contains("decoders")) {
+            fastModel.decoders = fast["decoders"].get<int>();
+        }
+    }
+    if (json["whisper"].contains("command_grammar")) {
+        const auto& grammar = json["whisper"]["command_grammar"];
+        if (grammar.contains("enabled")) {
+            commandGrammar.enabled = grammar["enabled"].get<bool>();
+        }
+        if (grammar.contains("penalty")) {
+            commandGrammar.penalty = grammar["penalty"].get<float>();
+        }
+    }
+    if (json["whisper"].contains("incremental_mel")) {
+        const auto& mel = json["whisper"]["incremental_mel"];
+        if (mel.contains("enabled")) {
+            incrementalMel.enabled = mel["enabled"].get<bool>();
+        }
+        if (mel.contains("n_mels")) {
+            incrementalMel.nMels = mel["n_mels"].get<int>();
+        }
+    }
+    if (json["whisper"].contains("speech_gate")) {
+        const auto& gate = json["whisper"]["speech_gate"];
+        if (gate.contains("enabled")) {
+            speechGate.enabled = gate["enabled"].get<bool>();
+        }
+        if (gate.contains("min_rms")) {
+            speechGate.minRms = gate["min_rms"].get<float>();
+        }
+        if (gate.contains("min_voiced_ms")) {
+            speechGate.minVoicedMs = gate["min_voiced_ms"].get<int>();
+        }
+        if (gate.contains("min_voiced_ratio")) {
+            speechGate.minVoicedRatio = gate["min_voiced_ratio"].get<float>();
+        }
+        if (gate.contains("no_speech_threshold")) {
+            speechGate.noSpeechThreshold = gate["no_speech_threshold"].get<float>();
+        }
+        if (gate.contains("logprob_threshold")) {
+            speechGate.logprobThreshold = gate["logprob_threshold"].get<float>();
+        }
+        if (gate.contains("early_stop_threshold")) {
+            speechGate.earlyStopThreshold = gate["early_stop_threshold"].get<float>();
+        }
+    }
+    if (json["whisper"].contains("batching")) {
+        const auto& batch = json["whisper"]["batching"];
+        if (batch.contains("enabled")) {
+            batching.enabled = batch["enabled"].get<bool>();
+        }
+        if (batch.contains("max_utterance_sec")) {
+            batching.maxUtteranceSec = batch["max_utterance_sec"].get<float>();
+        }
+        if (batch.contains("max_batch_sec")) {
+            batching.maxBatchSec = batch["max_batch_sec"].get<float>();
+        }
+        if (batch.contains("gap_ms")) {
+            batching.gapMs = batch["gap_ms"].get<int>();
+        }
+        if (batch.contains("max_utterances")) {
+            batching.maxUtterances = batch["max_utterances"].get<int>();
+        }
+    }
+    if (json["whisper"].contains("parallel_split")) {
+        const auto& split = json["whisper"]["parallel_split"];
+        if (split.contains("enabled")) {
+            parallelSplit.enabled = split["enabled"].get<bool>();
+        }
+        if (split.contains("min_recording_sec")) {
+            parallelSplit.minRecordingSec = split["min_recording_sec"].get<float>();
+        }
+        if (split.contains("min_window_sec")) {
+            parallelSplit.minWindowSec = split["min_window_sec"].get<float>();
+        }
+        if (split.contains("max_window_sec")) {
+            parallelSplit.maxWindowSec = split["max_window_sec"].get<float>();
+        }
+        if (split.contains("search_ms")) {
+            parallelSplit.searchMs = split["search_ms"].get<int>();
+        }
+    }
 
     // Load output settings
     outputType = json["output"]["type"].get<std::string>();
@@ -149,6 +478,11 @@ bool Settings::load(const std::string& filename) {
         if (json["voice_commands"].contains("key_press")) {
             commands.keyPress = json["voice_commands"]["key_press"].get<std::vector<std::string>>();
         }
+        
+        // Load latency report commands
+        if (json["voice_commands"].contains("latency_report")) {
+            commands.latencyReport = json["voice_commands"]["latency_report"].get<std::vector<std::string>>();
+        }
     }
 
     return true;
@@ -12,19 +12,60 @@ public:
 
     // Audio settings
     std::string audioDevice;
+    std::string audioSource;  // "device", or a file/pipe spec such as "wav:talk.wav", "pcm:-"
     int sampleRate;
     float silenceThreshold;
     int silenceDurationMs;
+    int ringBufferMs;
     
     // Speech detection settings (for improved continuous mode)
     struct SpeechDetectionSettings {
         float threshold;
         int minSilenceMs;
+        int commandMinSilenceMs;  // End-of-speech silence in mouse mode, 0 = same as minSilenceMs
         int maxChunkSec;
+        int splitSearchMs;    // A chunk cut at max_chunk_sec ends at the quietest frame this far back
+        int splitOverlapMs;   // Audio before the cut repeated at the start of the next chunk
         int preSpeechBufferMs;
+        float maxZeroCrossingRate;
         bool enabled;
     };
     SpeechDetectionSettings speechDetection;
+    
+    // Push-to-talk capture buffer limits
+    struct CaptureSettings {
+        int maxMemoryMb;
+        bool spillToDisk;
+        int maxSpillMb;
+        std::string spillDir;
+    };
+    CaptureSettings capture;
+    
+    // Hand finished sentences of a push-to-talk recording to the decoder while the
+    // user keeps talking, so only the last one is left to decode after stop
+    struct PushToTalkPipelineSettings {
+        bool enabled;
+        int pauseMs;            // Pause (below silence_threshold) that ends a sentence
+        float minSegmentSec;    // Shorter stretches stay with the next sentence
+    };
+    PushToTalkPipelineSettings pushToTalkPipeline;
+    
+    // Continuous-mode chunks waiting for transcription
+    struct ChunkQueueSettings {
+        float maxQueuedSec;     // Queued audio beyond this triggers the overflow policy
+        std::string policy;     // "merge", "drop_oldest", "fast_model" or "none"
+        float maxMergedSec;     // Longest chunk the merge policy may build
+        float warnAgeSec;       // Warn when the oldest queued chunk is this old
+    };
+    ChunkQueueSettings chunkQueue;
+    
+    // Chrome trace-event export of the pipeline timeline
+    struct TracingSettings {
+        bool enabled;
+        std::string outputPath;
+        int maxEventsPerThread;  // Zones kept per thread; later ones are dropped
+    };
+    TracingSettings tracing;
 
     // Whisper settings
     std::string modelPath;
@@ -32,6 +73,94 @@ public:
     bool translate;
     int beamSize;
     int threads;
+    int maxQueuedJobs;  // Transcription jobs waiting for the inference worker
+    int parallelDecoders;  // Chunks decoded concurrently, each with its own whisper_state
+    bool warmup;           // Run a silent clip through each decoder after loading the model
+    
+    // Size the encoder context (audio_ctx) to each utterance instead of 30 s
+    struct DynamicAudioCtxSettings {
+        bool enabled;
+        int granularity;         // Round audio_ctx up to a multiple of this (50 = 1 s)
+        int marginMs;            // Extra audio context beyond the utterance
+        float fallbackLogprob;   // Retry with full context below this average token logprob
+    };
+    DynamicAudioCtxSettings dynamicAudioCtx;
+    
+    // Feed the tail of the previous continuous-mode text to the next chunk as a prompt
+    struct PromptContextSettings {
+        bool enabled;
+        int maxTokens;  // Rolling window size; whisper accepts at most half its text context
+    };
+    PromptContextSettings promptContext;
+    
+    // Start greedy and escalate to beam search / temperature sampling only when the
+    // result looks wrong, within a per-utterance latency budget
+    struct AdaptiveDecodingSettings {
+        bool enabled;
+        float logprobThreshold;           // Escalate below this average token logprob
+        float compressionRatioThreshold;  // Escalate above this (repetitive output)
+        float temperatureIncrement;       // Temperature step for sampling fallbacks, 0 = none
+        int latencyBudgetMs;              // Decode time allowed per utterance, 0 = unlimited
+    };
+    AdaptiveDecodingSettings adaptiveDecoding;
+    
+    // Optional smaller model for mouse-mode commands and short utterances
+    struct FastModelSettings {
+        std::string modelPath;   // Empty = disabled, everything goes to the main model
+        float maxUtteranceSec;   // Utterances up to this length use the fast model
+        bool useForMouseMode;    // Route everything spoken in mouse mode to the fast model
+        int decoders;            // whisper_states for the fast model
+    };
+    FastModelSettings fastModel;
+    
+    // Constrain mouse-mode decodes to the command phrases, key names and numbers
+    struct CommandGrammarSettings {
+        bool enabled;
+        float penalty;  // Logit penalty for tokens outside the grammar
+    };
+    CommandGrammarSettings commandGrammar;
+    
+    // Compute the log-mel spectrogram on the capture thread while speech is arriving
+    struct IncrementalMelSettings {
+        bool enabled;
+        int nMels;  // Must match the model (80, or 128 for large-v3); mismatches fall back to PCM
+    };
+    IncrementalMelSettings incrementalMel;
+    
+    // Skip whisper on chunks that are not speech: an energy/voicing check before
+    // inference and whisper's no-speech probability after the first pass
+    struct SpeechGateSettings {
+        bool enabled;
+        float minRms;               // Whole-chunk RMS below this is silence
+        int minVoicedMs;            // Voiced 20 ms frames needed, in total...
+        float minVoicedRatio;       // ...and as a fraction of the chunk
+        float noSpeechThreshold;    // No-speech probability above this...
+        float logprobThreshold;     // ...with an average token logprob below this is not speech
+        float earlyStopThreshold;   // Stop a single-window pass after its first step above this (0 = never)
+    };
+    SpeechGateSettings speechGate;
+    
+    // Decode several short queued utterances in one whisper pass, separated by silence,
+    // and split the text back out by token timestamps
+    struct BatchingSettings {
+        bool enabled;
+        float maxUtteranceSec;  // Only utterances up to this length are packed
+        float maxBatchSec;      // Packed length including gaps (whisper's window is 30 s)
+        int gapMs;              // Silence between utterances
+        int maxUtterances;      // Utterances per pass
+    };
+    BatchingSettings batching;
+    
+    // Split long push-to-talk recordings at quiet points into windows that the
+    // decoders transcribe concurrently, then join the text in order
+    struct ParallelSplitSettings {
+        bool enabled;
+        float minRecordingSec;  // Recordings shorter than this are decoded whole
+        float minWindowSec;     // Shortest window worth its own decode
+        float maxWindowSec;     // Longest window (whisper's window is 30 s)
+        int searchMs;           // How far either side of the even split to look for a quiet frame
+    };
+    ParallelSplitSettings parallelSplit;
 
     // Output settings
     std::string outputType;
@@ -55,6 +184,7 @@ public:
         std::vector<std::string> continuousMode;
         std::vector<std::string> exitContinuousMode;
         std::vector<std::string> keyPress;
+        std::vector<std::string> latencyReport;  // Log the per-stage latency histograms
     };
     VoiceCommands commands;
 
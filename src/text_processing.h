@@ -0,0 +1,24 @@
+#ifndef TEXT_PROCESSING_H
+#define TEXT_PROCESSING_H
+
+#include <string>
+#include <vector>
+
+// Normalize text for command matching: lowercase, punctuation removed
+std::string normalizeText(const std::string& input);
+
+// Check if text contains any command from a list of possible commands
+bool containsAnyCommand(const std::string& text, const std::vector<std::string>& commands);
+
+// Remove [BLANK_AUDIO] style noise markers and collapse whitespace
+std::string cleanTranscription(const std::string& text);
+
+// Append newText to previousText, dropping words repeated at the boundary
+std::string mergeContinuousText(const std::string& previousText, const std::string& newText);
+
+// Estimate the ratio zlib would achieve on text (original / compressed size) from a
+// deflate-style LZ77 parse and Huffman cost model, without depending on zlib.
+// Repetitive hallucinations ("thank you thank you ...") score far above normal speech.
+float textCompressionRatio(const std::string& text);
+
+#endif // TEXT_PROCESSING_H
@@ -0,0 +1,147 @@
+#include "trace.h"
+#include "logger.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Trace::enabled{false};
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    int64_t startNs;
+    int64_t durationNs;
+};
+
+// Written only by its own thread; count is published after each event so the
+// writer can read a consistent prefix while the thread keeps recording
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    std::string name;
+    std::unique_ptr<TraceEvent[]> events;
+    size_t capacity = 0;
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+// Buffers live until exit so zones from threads that already finished stay readable
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+size_t eventsPerThread = 0;
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+thread_local ThreadBuffer* threadBuffer = nullptr;
+thread_local std::string pendingThreadName;
+
+ThreadBuffer* currentBuffer() {
+    if (threadBuffer) {
+        return threadBuffer;
+    }
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (eventsPerThread == 0) {
+        return nullptr;
+    }
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+    buffer->tid = static_cast<uint32_t>(buffers.size() + 1);
+    buffer->name = pendingThreadName;
+    buffer->capacity = eventsPerThread;
+    buffer->events.reset(new TraceEvent[eventsPerThread]);
+    threadBuffer = buffer.get();
+    buffers.push_back(std::move(buffer));
+    return threadBuffer;
+}
+
+// Zone names are string literals, but escape them anyway
+std::string jsonString(const std::string& text) {
+    std::string result = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += (static_cast<unsigned char>(c) < 0x20) ? ' ' : c;
+    }
+    return result + "\"";
+}
+
+} // namespace
+
+void Trace::start(size_t maxEventsPerThread) {
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        // Buffers already handed out keep their size
+        if (eventsPerThread == 0) {
+            eventsPerThread = maxEventsPerThread > 0 ? maxEventsPerThread : 65536;
+        }
+    }
+    enabled.store(true);
+    Logger::info("Tracing enabled (" + std::to_string(eventsPerThread) + " zones per thread)");
+}
+
+void Trace::stop() {
+    enabled.store(false);
+}
+
+void Trace::setThreadName(const std::string& name) {
+    pendingThreadName = name;
+    if (threadBuffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        threadBuffer->name = name;
+    }
+}
+
+int64_t Trace::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Trace::record(const char* name, int64_t startNs, int64_t endNs) {
+    ThreadBuffer* buffer = currentBuffer();
+    if (!buffer) {
+        return;
+    }
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= buffer->capacity) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[index] = TraceEvent{name, startNs, endNs - startNs};
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+bool Trace::writeJson(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        Logger::error("Cannot write trace to " + path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t written = 0;
+    uint64_t dropped = 0;
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file, "{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"TurboTalkText\"}}");
+    for (const auto& buffer : buffers) {
+        std::string name = buffer->name.empty() ? "thread " + std::to_string(buffer->tid) : buffer->name;
+        std::fprintf(file, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":%s}}",
+                     buffer->tid, jsonString(name).c_str());
+
+        // Complete ("X") events with microsecond timestamps
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            const TraceEvent& event = buffer->events[i];
+            std::fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":%s,\"ts\":%.3f,\"dur\":%.3f}",
+                         buffer->tid, jsonString(event.name).c_str(),
+                         event.startNs / 1000.0, event.durationNs / 1000.0);
+        }
+        written += count;
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    std::fprintf(file, "\n]}\n");
+    bool ok = std::fclose(file) == 0;
+
+    Logger::info("Wrote " + std::to_string(written) + " trace zone(s) from " + std::to_string(buffers.size()) +
+                 " thread(s) to " + path + (dropped > 0 ? " (" + std::to_string(dropped) + " dropped, buffers full)" : ""));
+    return ok;
+}
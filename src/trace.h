@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Scoped timing zones written out as Chrome trace-event JSON, to open in
+// ui.perfetto.dev or chrome://tracing. Every thread records into its own fixed-size
+// buffer without locking; a lock is only taken the first time a thread records and
+// when the trace is written. When tracing is off a zone costs one atomic load.
+class Trace {
+public:
+    // Start recording, keeping up to maxEventsPerThread zones per thread
+    static void start(size_t maxEventsPerThread);
+    static void stop();
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Label the calling thread in the trace; may be called before start()
+    static void setThreadName(const std::string& name);
+
+    // Write every zone recorded so far; safe while other threads keep recording
+    static bool writeJson(const std::string& path);
+
+    // Nanoseconds on the trace clock
+    static int64_t now();
+
+    // Add a finished zone for the calling thread; name must outlive the trace
+    static void record(const char* name, int64_t startNs, int64_t endNs);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Records the enclosing scope as a zone
+class TraceScope {
+public:
+    explicit TraceScope(const char* name)
+        : name(Trace::isEnabled() ? name : nullptr), startNs(this->name ? Trace::now() : 0) {}
+    ~TraceScope() {
+        if (name) {
+            Trace::record(name, startNs, Trace::now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    int64_t startNs;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
@@ -1,51 +1,1312 @@
 #include "transcription.h"
 #include "logger.h"
+#include "trace.h"
+#include "text_processing.h"
+#include "audio_stats.h"
 #include <whisper.h>
+#include <algorithm>
+#include <cmath>
 
-Transcription::Transcription(const Settings& settings) : settings(settings), ctx(nullptr) {}
+Transcription::Transcription(const Settings& settings)
+    : settings(settings),
+      maxQueuedJobs(settings.maxQueuedJobs > 0 ? settings.maxQueuedJobs : 1) {
+    mainModel.route = TranscriptionRoute::MAIN;
+    mainModel.name = "main";
+    mainModel.path = settings.modelPath;
+    mainModel.decoderCount = settings.parallelDecoders > 0 ? settings.parallelDecoders : 1;
+
+    fastModel.route = TranscriptionRoute::FAST;
+    fastModel.name = "fast";
+    fastModel.path = settings.fastModel.modelPath;
+    fastModel.decoderCount = settings.fastModel.decoders > 0 ? settings.fastModel.decoders : 1;
+    fastModelEnabled = !fastModel.path.empty();
+}
 
 Transcription::~Transcription() {
-    if (ctx) {
-        whisper_free(ctx);
+    // Abort the decodes in flight, then fail whatever is still queued
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    aborting.store(true);
+    mainModel.jobAvailable.notify_all();
+    fastModel.jobAvailable.notify_all();
+    spaceAvailable.notify_all();
+
+    // A model load can't be interrupted; wait for it so the contexts and states are settled
+    if (loader.joinable()) {
+        loader.join();
+    }
+    for (Model* model : {&mainModel, &fastModel}) {
+        {
+            // No worker may have started if loading was still in progress
+            std::lock_guard<std::mutex> lock(jobMutex);
+            for (std::deque<Job>* queue : {&model->jobs, &model->splitJobs}) {
+                for (auto& job : *queue) {
+                    resolveJob(job, TranscriptionResult());
+                }
+                queue->clear();
+            }
+        }
+        for (auto& worker : model->workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+
+        for (whisper_state* state : model->states) {
+            whisper_free_state(state);
+        }
+        if (model->ctx) {
+            whisper_free(model->ctx);
+        }
     }
 }
 
 bool Transcription::init() {
+    Logger::info("Loading Whisper model in the background: " + settings.modelPath);
+    if (fastModelEnabled) {
+        Logger::info("Fast model for commands and short utterances: " + fastModel.path);
+    }
+    loader = std::thread(&Transcription::loaderLoop, this);
+    return true;
+}
+
+bool Transcription::isReady() const {
+    return mainModel.state.load() == ModelState::READY;
+}
+
+bool Transcription::hasFailed() const {
+    return mainModel.state.load() == ModelState::FAILED;
+}
+
+// Loader thread: the main model first so dictation is available as early as possible
+void Transcription::loaderLoop() {
+    Trace::setThreadName("model loader");
+    if (!loadModel(mainModel)) {
+        failQueuedJobs(mainModel);
+        return;
+    }
+
+    if (fastModelEnabled) {
+        if (!loadModel(fastModel)) {
+            // Everything keeps going to the main model
+            Logger::error("Fast model unavailable, routing everything to the main model");
+            failQueuedJobs(fastModel);
+            return;
+        }
+
+        // Prompt tokens are only meaningful to a model with the same vocabulary
+        fastContextCompatible = whisper_is_multilingual(fastModel.ctx) == whisper_is_multilingual(mainModel.ctx);
+        if (!fastContextCompatible) {
+            Logger::info("Fast model vocabulary differs from the main model; its chunks won't share prompt context");
+        }
+    }
+}
+
+// Model, decoder states and warm-up, then the workers
+bool Transcription::loadModel(Model& model) {
+    TRACE_SCOPE("Transcription::loadModel");
+    auto startTime = std::chrono::steady_clock::now();
+
     // Use the correct structure and function for Whisper.cpp context initialization
     struct whisper_context_params params = whisper_context_default_params();
-    ctx = whisper_init_from_file_with_params(settings.modelPath.c_str(), params);
-    if (!ctx) {
-        Logger::error("Failed to initialize Whisper context");
+    model.ctx = whisper_init_from_file_with_params_no_state(model.path.c_str(), params);
+    if (!model.ctx) {
+        Logger::error("Failed to initialize Whisper context for the " + model.name + " model");
+        return false;
+    }
+
+    // Each decoder gets its own state (KV cache and compute buffers) over the shared model
+    for (int i = 0; i < model.decoderCount; i++) {
+        whisper_state* state = whisper_init_state(model.ctx);
+        if (!state) {
+            Logger::error("Failed to initialize Whisper state " + std::to_string(i + 1));
+            break;
+        }
+        model.states.push_back(state);
+    }
+    if (model.states.empty()) {
         return false;
     }
+
+    // Split the configured threads across the decoders so they don't oversubscribe the cores
+    model.threadsPerDecoder = settings.threads / static_cast<int>(model.states.size());
+    if (model.threadsPerDecoder < 1) {
+        model.threadsPerDecoder = 1;
+    }
+
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    Logger::info("Whisper " + model.name + " model loaded in " + std::to_string(static_cast<int>(loadMs)) + " ms");
+
+    // Capture-time spectrograms only help if they have the model's band count
+    if (settings.incrementalMel.enabled && whisper_model_n_mels(model.ctx) != settings.incrementalMel.nMels) {
+        Logger::info("The " + model.name + " model uses " + std::to_string(whisper_model_n_mels(model.ctx)) +
+                     " mel bands, not " + std::to_string(settings.incrementalMel.nMels) +
+                     "; it will compute its own spectrograms");
+    }
+
+    // Make the first real utterance as fast as the rest
+    if (settings.warmup) {
+        auto warmupStart = std::chrono::steady_clock::now();
+        for (whisper_state* state : model.states) {
+            warmUp(model, state);
+        }
+        double warmupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - warmupStart).count();
+        Logger::info("Whisper " + model.name + " warm-up took " + std::to_string(static_cast<int>(warmupMs)) + " ms");
+    }
+
+    // Start one inference worker per state; they pick up anything queued during the load
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        if (stopping) {
+            return true;
+        }
+        for (whisper_state* state : model.states) {
+            model.workers.emplace_back(&Transcription::workerLoop, this, &model, state);
+        }
+        model.state.store(ModelState::READY);
+    }
+    Logger::info("Transcription workers started for the " + model.name + " model: " +
+                 std::to_string(model.states.size()) + " decoder(s), " +
+                 std::to_string(model.threadsPerDecoder) + " thread(s) each, queue limit " +
+                 std::to_string(maxQueuedJobs) + " jobs");
     return true;
 }
 
+// Run a short silent clip through a state so the weights are paged in and the
+// compute buffers touched before the first real utterance
+void Transcription::warmUp(Model& model, whisper_state* state) {
+    TRACE_SCOPE("Transcription::warmUp");
+    // Whisper skips clips under a second, so use two
+    std::vector<float> silence(2 * WHISPER_SAMPLE_RATE, 0.0f);
+    DecodeOptions options;
+    options.whisperFallback = false;
+    if (settings.dynamicAudioCtx.enabled) {
+        options.audioCtx = computeAudioCtx(silence.size(), WHISPER_SAMPLE_RATE,
+                                           settings.dynamicAudioCtx.marginMs, settings.dynamicAudioCtx.granularity);
+    }
+    TranscriptionResult ignored;
+    decode(model, state, silence, options, std::vector<whisper_token>(), ignored);
+}
+
+// The model is unusable: resolve everything queued for it and refuse new jobs
+void Transcription::failQueuedJobs(Model& model) {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    model.state.store(ModelState::FAILED);
+    for (std::deque<Job>* queue : {&model.jobs, &model.splitJobs}) {
+        for (auto& job : *queue) {
+            resolveJob(job, TranscriptionResult());
+        }
+        queue->clear();
+    }
+    spaceAvailable.notify_all();
+}
+
+// Mouse-mode commands and short utterances go to the fast model once it is ready;
+// anything queued for it before then would wait on its load, so use the main model
+bool Transcription::routesToFast(size_t sampleCount, bool commandMode, bool preferFast) const {
+    if (!fastModelEnabled || fastModel.state.load() != ModelState::READY) {
+        return false;
+    }
+    if ((commandMode && settings.fastModel.useForMouseMode) || preferFast) {
+        return true;
+    }
+    double seconds = static_cast<double>(sampleCount) / WHISPER_SAMPLE_RATE;
+    return seconds <= settings.fastModel.maxUtteranceSec;
+}
+
+Transcription::Model& Transcription::routeFor(size_t sampleCount, bool commandMode, bool preferFast) {
+    return routesToFast(sampleCount, commandMode, preferFast) ? fastModel : mainModel;
+}
+
+std::future<TranscriptionResult> Transcription::submit(std::vector<float> audioData, bool useContext,
+                                                       bool commandMode, CancellationToken cancel) {
+    AudioChunk chunk;
+    chunk.samples = std::move(audioData);
+    return submit(std::move(chunk), useContext, commandMode, cancel);
+}
+
+std::future<TranscriptionResult> Transcription::submit(AudioChunk chunk, bool useContext,
+                                                       bool commandMode, CancellationToken cancel) {
+    TRACE_SCOPE("Transcription::submit");
+
+    // Silence and noise never reach whisper; the result is an empty success
+    SpeechGateVerdict verdict = checkSpeechGate(chunk.samples, chunk.voicedThreshold);
+    if (verdict != SpeechGateVerdict::SPEECH) {
+        TranscriptionResult skipped;
+        skipped.success = true;
+        skipped.gate = verdict;
+        skipped.audioSeconds = static_cast<double>(chunk.samples.size()) / WHISPER_SAMPLE_RATE;
+        skipped.timing = chunk.timing;
+        skipped.timing.enqueue = ChunkTiming::Clock::now();
+        Logger::info("Speech gate: skipped " + std::to_string(skipped.audioSeconds).substr(0, 4) + " s chunk (" +
+                     (verdict == SpeechGateVerdict::LOW_ENERGY ? "too quiet" : "not voiced") + ")");
+
+        std::promise<TranscriptionResult> promise;
+        promise.set_value(std::move(skipped));
+        return promise.get_future();
+    }
+
+    Model& model = routeFor(chunk.samples.size(), commandMode, chunk.preferFast);
+
+    // A long recording that needs no prompt runs as concurrent windows on the model's decoders
+    if (!useContext && !commandMode) {
+        std::vector<size_t> cuts = planSplit(chunk.samples, static_cast<size_t>(model.decoderCount),
+                                             settings.parallelSplit);
+        if (!cuts.empty()) {
+            return submitSplit(model, std::move(chunk), cuts, cancel);
+        }
+    }
+
+    Job job;
+    job.audio = std::move(chunk.samples);
+    job.mel = std::move(chunk.mel);
+    job.useContext = useContext && (model.route == TranscriptionRoute::MAIN || fastContextCompatible);
+    job.commandMode = commandMode;
+    job.cancel = cancel;
+    job.timing = chunk.timing;
+    job.timing.enqueue = ChunkTiming::Clock::now();
+    std::future<TranscriptionResult> result = job.promise.get_future();
+
+    {
+        std::unique_lock<std::mutex> lock(jobMutex);
+        spaceAvailable.wait(lock, [this, &model] { return stopping || model.jobs.size() < maxQueuedJobs; });
+        if (stopping || model.state.load() == ModelState::FAILED) {
+            job.promise.set_value(TranscriptionResult());
+            return result;
+        }
+        model.jobs.push_back(std::move(job));
+    }
+    model.jobAvailable.notify_one();
+    return result;
+}
+
+// Cut points for splitting a recording into windows, one per decoder as long as each
+// window stays worth its own decode, and enough that none is longer than whisper's
+// window. Each cut is placed on the quietest 20 ms frame near the even split so no
+// word is cut in half. Empty when the recording should be decoded whole.
+std::vector<size_t> planSplit(const std::vector<float>& audioData, size_t decoders,
+                              const Settings::ParallelSplitSettings& split) {
+    std::vector<size_t> cuts;
+    const size_t count = audioData.size();
+    if (!split.enabled || decoders < 2 ||
+        static_cast<double>(count) / WHISPER_SAMPLE_RATE < split.minRecordingSec) {
+        return cuts;
+    }
+
+    const size_t minWindow = static_cast<size_t>(std::max(split.minWindowSec, 1.0f) * WHISPER_SAMPLE_RATE);
+    const size_t maxWindow = std::max(minWindow,
+                                      static_cast<size_t>(std::min(split.maxWindowSec, 29.0f) * WHISPER_SAMPLE_RATE));
+    size_t windows = std::min(decoders, count / minWindow);
+    windows = std::max(windows, (count + maxWindow - 1) / maxWindow);
+    if (windows < 2) {
+        return cuts;
+    }
+
+    const size_t frameSize = WHISPER_SAMPLE_RATE / 50;
+    const size_t search = static_cast<size_t>(std::max(split.searchMs, 0)) * WHISPER_SAMPLE_RATE / 1000;
+    size_t previous = 0;
+    for (size_t k = 1; k < windows; k++) {
+        size_t target = count / windows * k;
+        size_t remaining = windows - k;
+
+        // Keep this window and every later one between half the minimum and the maximum
+        size_t low = std::max(target > search ? target - search : 0, previous + minWindow / 2);
+        if (count > remaining * maxWindow) {
+            low = std::max(low, count - remaining * maxWindow);
+        }
+        size_t high = std::min({target + search, previous + maxWindow, count - remaining * (minWindow / 2)});
+
+        size_t cut = std::min(std::max(target, low), high);
+        if (high > low + frameSize) {
+            cut = findQuietestFrame(audioData.data(), low, high, frameSize) + frameSize / 2;
+        }
+        cuts.push_back(cut);
+        previous = cut;
+    }
+    return cuts;
+}
+
+// Queue the windows of a split recording back to back, so the decoders pick them up
+// together. Each window passes the speech gate on its own. The windows go to the
+// model's split backlog, which the bounded queue doesn't count: a long dictation
+// plans more windows than fit there, and the caller is the main loop.
+std::future<TranscriptionResult> Transcription::submitSplit(Model& model, AudioChunk chunk,
+                                                            const std::vector<size_t>& cuts,
+                                                            CancellationToken cancel) {
+    TRACE_SCOPE("Transcription::submitSplit");
+    std::shared_ptr<SplitRecording> split = std::make_shared<SplitRecording>();
+    split->parts.resize(cuts.size() + 1);
+    split->remaining = split->parts.size();
+    split->edges.push_back(0);
+    split->edges.insert(split->edges.end(), cuts.begin(), cuts.end());
+    split->edges.push_back(chunk.samples.size());
+    split->timing = chunk.timing;
+    split->timing.enqueue = ChunkTiming::Clock::now();
+    std::future<TranscriptionResult> result = split->promise.get_future();
+
+    // Windows go through whisper's own spectrogram; the chunk's covers the whole recording
+    std::vector<Job> jobs(split->parts.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        jobs[i].audio.assign(chunk.samples.begin() + split->edges[i], chunk.samples.begin() + split->edges[i + 1]);
+        jobs[i].cancel = cancel;
+        jobs[i].timing = split->timing;
+        jobs[i].split = split;
+        jobs[i].splitIndex = i;
+    }
+    Logger::info("Splitting " + std::to_string(static_cast<double>(chunk.samples.size()) / WHISPER_SAMPLE_RATE).substr(0, 5) +
+                 " s recording into " + std::to_string(jobs.size()) + " windows for " +
+                 std::to_string(model.decoderCount) + " " + model.name + " decoder(s)");
+    {
+        std::lock_guard<std::mutex> lock(costMutex);
+        model.stats.splitRecordings++;
+    }
+
+    std::vector<Job> voiced;
+    for (Job& job : jobs) {
+        // A silent window resolves at once as an empty success
+        SpeechGateVerdict verdict = checkSpeechGate(job.audio, chunk.voicedThreshold);
+        if (verdict != SpeechGateVerdict::SPEECH) {
+            TranscriptionResult skipped;
+            skipped.success = true;
+            skipped.gate = verdict;
+            skipped.audioSeconds = static_cast<double>(job.audio.size()) / WHISPER_SAMPLE_RATE;
+            skipped.timing = job.timing;
+            Logger::info("Speech gate: skipped window " + std::to_string(job.splitIndex + 1) + " of " +
+                         std::to_string(jobs.size()) + " (" +
+                         (verdict == SpeechGateVerdict::LOW_ENERGY ? "too quiet" : "not voiced") + ")");
+            resolveJob(job, std::move(skipped));
+            continue;
+        }
+        voiced.push_back(std::move(job));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        bool accepted = !stopping && model.state.load() != ModelState::FAILED;
+        for (Job& job : voiced) {
+            if (accepted) {
+                model.splitJobs.push_back(std::move(job));
+            } else {
+                resolveJob(job, TranscriptionResult());
+            }
+        }
+    }
+    model.jobAvailable.notify_all();
+    return result;
+}
+
+// Hand a finished job its result; a split recording's window waits for its siblings
+void Transcription::resolveJob(Job& job, TranscriptionResult result) {
+    if (!job.split) {
+        job.promise.set_value(std::move(result));
+        return;
+    }
+
+    SplitRecording& split = *job.split;
+    {
+        std::lock_guard<std::mutex> lock(split.mutex);
+        split.parts[job.splitIndex] = std::move(result);
+        if (--split.remaining > 0) {
+            return;
+        }
+    }
+    // Last window: nobody else touches the parts any more
+    split.promise.set_value(joinSplit(split));
+}
+
+// Join the windows' results in order. A window that failed or was cancelled leaves a
+// gap, reported in failedSpans; the recording fails only if no window succeeded.
+// Inference time is the wall-clock span from the first window starting to the last
+// one finishing.
+TranscriptionResult Transcription::joinSplit(SplitRecording& split) {
+    std::vector<TranscriptionResult>& parts = split.parts;
+    TranscriptionResult joined;
+    joined.timing = split.timing;
+    joined.timing.decodeStart = ChunkTiming::Clock::time_point();
+    joined.audioSeconds = static_cast<double>(split.edges.back()) / WHISPER_SAMPLE_RATE;
+    joined.splitParts = static_cast<int>(parts.size());
+    joined.gate = parts[0].gate;
+
+    double logprobSum = 0.0;
+    size_t logprobTokens = 0;
+    bool anyCancelled = false;
+    std::string failedList;
+    for (size_t i = 0; i < parts.size(); i++) {
+        TranscriptionResult& part = parts[i];
+        if (!part.success || part.cancelled) {
+            double from = static_cast<double>(split.edges[i]) / WHISPER_SAMPLE_RATE;
+            double to = static_cast<double>(split.edges[i + 1]) / WHISPER_SAMPLE_RATE;
+            joined.failedSpans.emplace_back(from, to);
+            failedList += (failedList.empty() ? "" : ", ") + std::to_string(from).substr(0, 5) + "-" +
+                          std::to_string(to).substr(0, 5) + " s";
+            anyCancelled = anyCancelled || part.cancelled;
+            continue;
+        }
+        if (!joined.success) {
+            joined.success = true;
+            joined.route = part.route;
+            joined.queueMs = part.queueMs;
+            joined.audioCtx = part.audioCtx;
+            joined.strategy = part.strategy;
+        }
+        joined.fullContextFallback = joined.fullContextFallback || part.fullContextFallback;
+        joined.budgetExhausted = joined.budgetExhausted || part.budgetExhausted;
+        joined.noSpeechProb = std::max(joined.noSpeechProb, part.noSpeechProb);
+        joined.noSpeechSegments += part.noSpeechSegments;
+        if (part.gate == SpeechGateVerdict::SPEECH) {
+            joined.gate = SpeechGateVerdict::SPEECH;
+        }
+
+        if (!part.text.empty()) {
+            if (!joined.text.empty() && joined.text.back() != ' ' && part.text.front() != ' ') {
+                joined.text += ' ';
+            }
+            joined.text += part.text;
+        }
+        joined.tokens.insert(joined.tokens.end(), part.tokens.begin(), part.tokens.end());
+        joined.attempts.insert(joined.attempts.end(), part.attempts.begin(), part.attempts.end());
+        logprobSum += static_cast<double>(part.avgLogprob) * part.tokens.size();
+        logprobTokens += part.tokens.size();
+
+        if (ChunkTiming::isSet(part.timing.decodeStart) &&
+            (!ChunkTiming::isSet(joined.timing.decodeStart) || part.timing.decodeStart < joined.timing.decodeStart)) {
+            joined.timing.decodeStart = part.timing.decodeStart;
+        }
+        if (part.timing.decodeEnd > joined.timing.decodeEnd) {
+            joined.timing.decodeEnd = part.timing.decodeEnd;
+        }
+    }
+    joined.avgLogprob = logprobTokens > 0 ? static_cast<float>(logprobSum / logprobTokens) : 0.0f;
+    if (ChunkTiming::isSet(joined.timing.decodeStart)) {
+        joined.inferenceMs = std::chrono::duration<double, std::milli>(joined.timing.decodeEnd -
+                                                                       joined.timing.decodeStart).count();
+    }
+
+    // Same as a single job: a cancelled recording produces no text
+    joined.cancelled = !joined.success && anyCancelled;
+    if (!failedList.empty()) {
+        Logger::error("Split recording: " + std::to_string(joined.failedSpans.size()) + " of " +
+                      std::to_string(parts.size()) + " windows failed (" + failedList + ")" +
+                      (joined.success ? ", keeping the text of the others" : ""));
+    }
+    return joined;
+}
+
+bool Transcription::canSubmit(const AudioChunk& chunk, bool commandMode) const {
+    // The same routing submit() applies, so the check is against the queue the chunk joins
+    const Model& model = routesToFast(chunk.samples.size(), commandMode, chunk.preferFast) ? fastModel : mainModel;
+    std::lock_guard<std::mutex> lock(jobMutex);
+    return model.jobs.size() < maxQueuedJobs;
+}
+
+size_t Transcription::pendingJobs() const {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    return mainModel.jobs.size() + mainModel.splitJobs.size() + fastModel.jobs.size() +
+           fastModel.splitJobs.size() + activeJobs;
+}
+
 std::string Transcription::transcribe(const std::vector<float>& audioData) {
-    if (!ctx) {
-        Logger::error("Whisper context not initialized");
-        return "";
+    TRACE_SCOPE("Transcription::transcribe");
+    return submit(audioData).get().text;
+}
+
+void Transcription::commitContext(const TranscriptionResult& result) {
+    if (!settings.promptContext.enabled || !result.success) {
+        return;
+    }
+    // Token ids from a model with another vocabulary would be garbage to the main model
+    if (result.route == TranscriptionRoute::FAST && !fastContextCompatible) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(contextMutex);
+    contextTokens.insert(contextTokens.end(), result.tokens.begin(), result.tokens.end());
+    while (contextTokens.size() > static_cast<size_t>(std::max(settings.promptContext.maxTokens, 0))) {
+        contextTokens.pop_front();
     }
+}
+
+void Transcription::resetContext() {
+    std::lock_guard<std::mutex> lock(contextMutex);
+    contextTokens.clear();
+}
+
+void Transcription::setCommandGrammar(const CommandVocabulary& vocabulary) {
+    commandGrammar.reset(new CommandGrammar(vocabulary));
+    Logger::info("Command grammar: " + std::to_string(commandGrammar->phraseCount()) + " phrase(s), " +
+                 std::to_string(commandGrammar->ruleCount()) + " rule(s)");
+}
+
+RouteStats Transcription::getRouteStats(TranscriptionRoute route) const {
+    std::lock_guard<std::mutex> lock(costMutex);
+    return route == TranscriptionRoute::FAST ? fastModel.stats : mainModel.stats;
+}
 
-    // Set up transcription parameters (adjust based on Whisper.cpp API)
-    struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+SpeechGateStats Transcription::getSpeechGateStats() const {
+    std::lock_guard<std::mutex> lock(costMutex);
+    return gateStats;
+}
+
+void Transcription::logRouteStats() const {
+    SpeechGateStats gate = getSpeechGateStats();
+    if (gate.checked > 0) {
+        Logger::info("Speech gate: " + std::to_string(gate.checked) + " chunk(s) checked, skipped " +
+                     std::to_string(gate.lowEnergy) + " quiet and " + std::to_string(gate.unvoiced) +
+                     " unvoiced (" + std::to_string(gate.skippedAudioSeconds).substr(0, 6) + " s audio), dropped " +
+                     std::to_string(gate.noSpeech) + " as no-speech after decoding (" +
+                     std::to_string(gate.earlyStops) + " stopped after the first step) and " +
+                     std::to_string(gate.noSpeechSegments) + " no-speech segment(s) from kept text");
+    }
+    for (const Model* model : {&mainModel, &fastModel}) {
+        RouteStats stats = getRouteStats(model->route);
+        if (stats.cancelled > 0) {
+            Logger::info("Route " + model->name + ": " + std::to_string(stats.cancelled) + " cancelled job(s), " +
+                         std::to_string(static_cast<int>(stats.wastedMs)) + " ms of inference wasted");
+        }
+        if (stats.utterances == 0) {
+            continue;
+        }
+        double rtf = stats.audioSeconds > 0.0 ? stats.inferenceMs / 1000.0 / stats.audioSeconds : 0.0;
+        Logger::info("Route " + model->name + ": " + std::to_string(stats.utterances) + " utterance(s), " +
+                     std::to_string(stats.audioSeconds).substr(0, 6) + " s audio, avg inference " +
+                     std::to_string(static_cast<int>(stats.inferenceMs / stats.utterances)) + " ms, avg queue " +
+                     std::to_string(static_cast<int>(stats.queueMs / stats.utterances)) + " ms, RTF " +
+                     std::to_string(rtf).substr(0, 5) +
+                     (stats.batches > 0 ? ", " + std::to_string(stats.batchedUtterances) + " batched into " +
+                                              std::to_string(stats.batches) + " pass(es)" : "") +
+                     (stats.splitRecordings > 0 ? ", " + std::to_string(stats.splitRecordings) +
+                                                      " long recording(s) split across decoders" : ""));
+    }
+}
+
+// Worker thread: owns one whisper_state; the model's shared weights are read-only
+void Transcription::workerLoop(Model* model, whisper_state* state) {
+    Trace::setThreadName(model->name + " decoder");
+    while (true) {
+        std::vector<Job> batch;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            model->jobAvailable.wait(lock, [this, model] {
+                return stopping || !model->jobs.empty() || !model->splitJobs.empty();
+            });
+            if (stopping) {
+                // Resolve abandoned jobs so nobody waits on them forever
+                for (std::deque<Job>* queue : {&model->jobs, &model->splitJobs}) {
+                    for (auto& abandoned : *queue) {
+                        resolveJob(abandoned, TranscriptionResult());
+                    }
+                    queue->clear();
+                }
+                return;
+            }
+            // Whichever was submitted first: a split window or the next queued job
+            if (!model->splitJobs.empty() &&
+                (model->jobs.empty() || model->splitJobs.front().timing.enqueue <= model->jobs.front().timing.enqueue)) {
+                batch.push_back(std::move(model->splitJobs.front()));
+                model->splitJobs.pop_front();
+            } else {
+                batch.push_back(std::move(model->jobs.front()));
+                model->jobs.pop_front();
+                collectBatch(*model, batch);
+            }
+            activeJobs += batch.size();
+        }
+        spaceAvailable.notify_all();
+
+        // Jobs cancelled while queued are dropped without touching whisper
+        auto startTime = std::chrono::steady_clock::now();
+        std::vector<TranscriptionResult> results;
+        if (batch.size() > 1) {
+            results = runBatch(*model, state, batch);
+        } else {
+            results.resize(1);
+            if (!batch[0].cancel.isCancelled()) {
+                results[0] = runInference(*model, state, batch[0]);
+            }
+        }
+        auto endTime = std::chrono::steady_clock::now();
+        double inferenceMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            Job& job = batch[i];
+            TranscriptionResult& result = results[i];
+
+            // A cancelled job's output is unwanted, even if its decode got to finish
+            if (job.cancel.isCancelled()) {
+                result = TranscriptionResult();
+                result.cancelled = true;
+            }
+            result.route = model->route;
+            result.batchSize = static_cast<int>(batch.size());
+            result.queueMs = std::chrono::duration<double, std::milli>(startTime - job.timing.enqueue).count();
+            result.inferenceMs = inferenceMs;
+            result.timing = job.timing;
+            result.timing.decodeStart = startTime;
+            result.timing.decodeEnd = endTime;
+
+            // A packed pass is counted once, against its first utterance
+            std::lock_guard<std::mutex> lock(costMutex);
+            if (result.cancelled) {
+                model->stats.cancelled++;
+                model->stats.wastedMs += i == 0 ? inferenceMs : 0.0;
+            } else {
+                if (result.gate == SpeechGateVerdict::NO_SPEECH) {
+                    gateStats.noSpeech++;
+                } else {
+                    gateStats.noSpeechSegments += static_cast<uint64_t>(result.noSpeechSegments);
+                }
+                model->stats.utterances++;
+                model->stats.audioSeconds += static_cast<double>(job.audio.size()) / WHISPER_SAMPLE_RATE;
+                model->stats.inferenceMs += i == 0 ? inferenceMs : 0.0;
+                model->stats.queueMs += result.queueMs;
+            }
+        }
+        if (batch.size() > 1) {
+            std::lock_guard<std::mutex> lock(costMutex);
+            model->stats.batches++;
+            model->stats.batchedUtterances += batch.size();
+        }
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            activeJobs -= batch.size();
+        }
+        for (size_t i = 0; i < batch.size(); i++) {
+            resolveJob(batch[i], std::move(results[i]));
+        }
+    }
+}
+
+// Whether a job may share a pass: short, not cancelled, and free to produce timestamps
+// (grammar-constrained commands are decoded as one timestamp-less segment)
+bool Transcription::isBatchable(const Job& job) const {
+    // Windows of a split recording are meant to run side by side
+    if (job.cancel.isCancelled() || job.split) {
+        return false;
+    }
+    if (job.commandMode && settings.commandGrammar.enabled && commandGrammar && !commandGrammar->empty()) {
+        return false;
+    }
+    return job.audio.size() <= static_cast<size_t>(settings.batching.maxUtteranceSec * WHISPER_SAMPLE_RATE);
+}
+
+// Move queued jobs that fit into the pass after the first one (jobMutex is held)
+void Transcription::collectBatch(Model& model, std::vector<Job>& batch) {
+    const Settings::BatchingSettings& batching = settings.batching;
+    if (!batching.enabled || batching.maxUtterances < 2 || !isBatchable(batch[0])) {
+        return;
+    }
+
+    const size_t gapSamples = static_cast<size_t>(std::max(batching.gapMs, 0)) * WHISPER_SAMPLE_RATE / 1000;
+    const size_t maxSamples = static_cast<size_t>(std::min(batching.maxBatchSec, 29.0f) * WHISPER_SAMPLE_RATE);
+    size_t total = batch[0].audio.size();
+    while (!model.jobs.empty() && batch.size() < static_cast<size_t>(batching.maxUtterances)) {
+        const Job& next = model.jobs.front();
+        // Context only flows from the first utterance, so the rest must want the same
+        if (!isBatchable(next) || next.useContext != batch[0].useContext ||
+            total + gapSamples + next.audio.size() > maxSamples) {
+            break;
+        }
+        total += gapSamples + next.audio.size();
+        batch.push_back(std::move(model.jobs.front()));
+        model.jobs.pop_front();
+    }
+}
+
+// Decode the batch as one clip with silence between the utterances, then hand each
+// utterance the tokens whose timestamps fall inside it
+std::vector<TranscriptionResult> Transcription::runBatch(Model& model, whisper_state* state,
+                                                         std::vector<Job>& batch) {
+    TRACE_SCOPE("Transcription::runBatch");
+    const size_t gapSamples = static_cast<size_t>(std::max(settings.batching.gapMs, 0)) * WHISPER_SAMPLE_RATE / 1000;
+
+    // The first utterance brings the prompt context and the cancellation token; the
+    // packed clip goes through whisper's own spectrogram
+    Job packed;
+    packed.useContext = batch[0].useContext;
+    packed.cancel = batch[0].cancel;
+    packed.tokenTimestamps = true;
+    std::vector<size_t> starts;
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (i > 0) {
+            packed.audio.insert(packed.audio.end(), gapSamples, 0.0f);
+        }
+        starts.push_back(packed.audio.size());
+        packed.audio.insert(packed.audio.end(), batch[i].audio.begin(), batch[i].audio.end());
+    }
+
+    TranscriptionResult combined = runInference(model, state, packed);
+
+    std::vector<TranscriptionResult> results(batch.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+        TranscriptionResult& result = results[i];
+        result.success = combined.success;
+        result.audioSeconds = static_cast<double>(batch[i].audio.size()) / WHISPER_SAMPLE_RATE;
+        result.audioCtx = combined.audioCtx;
+        result.avgLogprob = combined.avgLogprob;
+        result.fullContextFallback = combined.fullContextFallback;
+        result.promptTokens = i == 0 ? combined.promptTokens : 0;
+        result.strategy = combined.strategy;
+        result.attempts = combined.attempts;
+        result.budgetExhausted = combined.budgetExhausted;
+        result.gate = combined.gate;
+        result.noSpeechProb = combined.noSpeechProb;
+    }
+
+    // Token times are in 10 ms units from the start of the packed clip; a token in a gap
+    // goes to the nearer utterance
+    for (const TimedToken& token : combined.timedTokens) {
+        int64_t t0 = token.t0;
+        int64_t t1 = std::max(token.t1, token.t0);
+        size_t position = static_cast<size_t>(std::max<int64_t>(0, (t0 + t1) / 2)) * WHISPER_SAMPLE_RATE / 100;
+        size_t owner = 0;
+        for (size_t i = 1; i < batch.size(); i++) {
+            if (position >= starts[i] - gapSamples / 2) {
+                owner = i;
+            }
+        }
+        results[owner].text += token.text;
+        results[owner].tokens.push_back(token.id);
+    }
+
+    Logger::info("Batched " + std::to_string(batch.size()) + " utterances (" +
+                 std::to_string(static_cast<double>(packed.audio.size()) / WHISPER_SAMPLE_RATE).substr(0, 4) +
+                 " s packed) into one pass");
+    return results;
+}
+
+VoicingStats measureVoicing(const float* samples, size_t count, int sampleRate,
+                            float frameThreshold, float maxZeroCrossingRate) {
+    VoicingStats stats;
+    if (!samples || count == 0 || sampleRate <= 0) {
+        return stats;
+    }
+
+    const size_t frameSize = std::max(1, sampleRate / 50);
+    double sumSquares = 0.0;
+    for (size_t offset = 0; offset < count; offset += frameSize) {
+        AudioBlockStats frame = computeBlockStats(samples + offset, std::min(frameSize, count - offset));
+        sumSquares += frame.sumSquares;
+        stats.frames++;
+        if (frame.rms() > frameThreshold &&
+            (maxZeroCrossingRate <= 0.0f || frame.zeroCrossingRate() <= maxZeroCrossingRate)) {
+            stats.voicedFrames++;
+        }
+    }
+    stats.rms = static_cast<float>(std::sqrt(sumSquares / count));
+    return stats;
+}
+
+// Whisper's encoder sees 1500 frames (50 per second) for its 30 s window
+static const int FULL_AUDIO_CTX = 1500;
+static const int AUDIO_CTX_PER_SECOND = 50;
+
+int computeAudioCtx(size_t sampleCount, int sampleRate, int marginMs, int granularity) {
+    if (sampleRate <= 0 || granularity <= 0) {
+        return 0;
+    }
+
+    double seconds = static_cast<double>(sampleCount) / sampleRate + marginMs / 1000.0;
+    int frames = static_cast<int>(std::ceil(seconds * AUDIO_CTX_PER_SECOND));
+    int audioCtx = ((frames + granularity - 1) / granularity) * granularity;
+    return audioCtx >= FULL_AUDIO_CTX ? 0 : audioCtx;
+}
+
+TranscriptionResult Transcription::runInference(Model& model, whisper_state* state, const Job& job) {
+    TRACE_SCOPE("Transcription::runInference");
+    const std::vector<float>& audioData = job.audio;
+
+    // Encode only as much context as the utterance needs
+    int audioCtx = 0;
+    if (settings.dynamicAudioCtx.enabled) {
+        audioCtx = computeAudioCtx(audioData.size(), WHISPER_SAMPLE_RATE,
+                                   settings.dynamicAudioCtx.marginMs, settings.dynamicAudioCtx.granularity);
+    }
+
+    // Snapshot the committed context for this chunk's prompt
+    std::vector<whisper_token> prompt;
+    if (job.useContext && settings.promptContext.enabled) {
+        std::lock_guard<std::mutex> lock(contextMutex);
+        prompt.assign(contextTokens.begin(), contextTokens.end());
+    }
+
+    // What every pass of this job shares
+    DecodeOptions base;
+    base.audioCtx = audioCtx;
+    base.cancel = &job.cancel;
+    base.tokenTimestamps = job.tokenTimestamps;
+    if (!job.mel.empty()) {
+        base.mel = &job.mel;
+    }
+
+    // Commands are decoded against the command language only
+    if (job.commandMode && settings.commandGrammar.enabled && commandGrammar && !commandGrammar->empty()) {
+        base.grammar = commandGrammar.get();
+    }
+
+    if (settings.adaptiveDecoding.enabled) {
+        return runAdaptive(model, state, audioData, base, prompt);
+    }
+
+    // Fixed strategy: beam search when beam_size asks for it, with whisper's own fallback
+    TranscriptionResult result;
+    result.audioSeconds = static_cast<double>(audioData.size()) / WHISPER_SAMPLE_RATE;
+    DecodeOptions options = base;
+    options.sampling = settings.beamSize > 1 ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
+    if (!decode(model, state, audioData, options, prompt, result)) {
+        return result;
+    }
+    result.strategy = strategyName(options);
+
+    // Noise won't decode any better with the full window
+    if (result.gate == SpeechGateVerdict::NO_SPEECH) {
+        Logger::info("No speech (probability " + std::to_string(result.noSpeechProb).substr(0, 4) +
+                     "), skipping the full-context retry");
+        return result;
+    }
+
+    // A truncated context can hurt accuracy; redo low-confidence decodes with the full window
+    if (audioCtx > 0 && result.avgLogprob < settings.dynamicAudioCtx.fallbackLogprob && !job.cancel.isCancelled()) {
+        Logger::info("Low confidence with audio_ctx " + std::to_string(audioCtx) +
+                     " (avg logprob " + std::to_string(result.avgLogprob) + "), retrying with full context");
+        TranscriptionResult fullResult;
+        fullResult.audioSeconds = result.audioSeconds;
+        options.audioCtx = 0;
+        if (decode(model, state, audioData, options, prompt, fullResult)) {
+            result = fullResult;
+            result.fullContextFallback = true;
+            result.strategy = strategyName(options);
+        }
+    }
+    return result;
+}
+
+// Escalate greedy -> full context -> beam search -> temperature sampling until a pass
+// looks right or the next pass would overrun the utterance's latency budget
+TranscriptionResult Transcription::runAdaptive(Model& model, whisper_state* state,
+                                               const std::vector<float>& audioData, const DecodeOptions& base,
+                                               const std::vector<whisper_token>& prompt) {
+    const Settings::AdaptiveDecodingSettings& adaptive = settings.adaptiveDecoding;
+    const double audioSeconds = static_cast<double>(audioData.size()) / WHISPER_SAMPLE_RATE;
+    const int audioCtx = base.audioCtx;
+    const CancellationToken& cancel = *base.cancel;
+
+    // Build the escalation ladder; we run the fallbacks ourselves so whisper's are off
+    std::vector<DecodeOptions> ladder;
+    DecodeOptions greedy = base;
+    greedy.whisperFallback = false;
+    ladder.push_back(greedy);
+    if (audioCtx > 0) {
+        DecodeOptions fullContext = greedy;
+        fullContext.audioCtx = 0;
+        ladder.push_back(fullContext);
+    }
+    if (settings.beamSize > 1) {
+        DecodeOptions beam = greedy;
+        beam.sampling = WHISPER_SAMPLING_BEAM_SEARCH;
+        beam.audioCtx = 0;
+        ladder.push_back(beam);
+    }
+    if (adaptive.temperatureIncrement > 0.0f) {
+        for (float temperature = adaptive.temperatureIncrement; temperature <= 1.0f + 1e-3f;
+             temperature += adaptive.temperatureIncrement) {
+            DecodeOptions sampled = greedy;
+            sampled.audioCtx = 0;
+            sampled.temperature = temperature;
+            ladder.push_back(sampled);
+        }
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    TranscriptionResult best;
+    best.audioSeconds = audioSeconds;
+    float bestRatio = 0.0f;
+    bool haveBest = false;
+    bool budgetExhausted = false;
+    bool noSpeech = false;
+    double firstPassMs = 0.0;
+    std::vector<DecodeAttempt> attempts;
+
+    for (size_t i = 0; i < ladder.size(); i++) {
+        const DecodeOptions& options = ladder[i];
+        if (cancel.isCancelled()) {
+            break;
+        }
+
+        // The first pass always runs; later ones only if they are expected to fit the budget
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        if (i > 0 && adaptive.latencyBudgetMs > 0 &&
+            elapsedMs + estimateCostMs(model, options, audioSeconds, firstPassMs) > adaptive.latencyBudgetMs) {
+            budgetExhausted = true;
+            break;
+        }
+
+        TranscriptionResult candidate;
+        candidate.audioSeconds = audioSeconds;
+        auto passStart = std::chrono::steady_clock::now();
+        bool decoded = decode(model, state, audioData, options, prompt, candidate);
+        double passMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - passStart).count();
+        if (i == 0) {
+            firstPassMs = passMs;
+        }
+        // An aborted or early-stopped pass says nothing about what a full one costs
+        if (!cancel.isCancelled() && candidate.gate != SpeechGateVerdict::NO_SPEECH) {
+            recordCost(model, options, audioSeconds, passMs);
+        }
+        if (!decoded) {
+            continue;
+        }
+
+        DecodeAttempt attempt;
+        attempt.strategy = strategyName(options);
+        attempt.audioCtx = options.audioCtx;
+        attempt.ms = passMs;
+        attempt.avgLogprob = candidate.avgLogprob;
+        attempt.compressionRatio = textCompressionRatio(candidate.text);
+        bool repetitive = attempt.compressionRatio > adaptive.compressionRatioThreshold;
+        attempt.accepted = !repetitive && attempt.avgLogprob >= adaptive.logprobThreshold;
+        attempts.push_back(attempt);
+
+        // Low confidence on audio whisper thinks is silence: escalating would only
+        // produce a more fluent hallucination, so stop with no text
+        if (candidate.gate == SpeechGateVerdict::NO_SPEECH) {
+            best = TranscriptionResult();
+            best.audioSeconds = audioSeconds;
+            best.success = true;
+            best.gate = SpeechGateVerdict::NO_SPEECH;
+            best.noSpeechProb = candidate.noSpeechProb;
+            best.audioCtx = candidate.audioCtx;
+            best.promptTokens = candidate.promptTokens;
+            best.strategy = attempt.strategy;
+            haveBest = true;
+            noSpeech = true;
+            break;
+        }
+
+        // Keep the best pass so far: non-repetitive first, then highest confidence
+        bool bestRepetitive = bestRatio > adaptive.compressionRatioThreshold;
+        if (!haveBest || (bestRepetitive && !repetitive) ||
+            (bestRepetitive == repetitive && candidate.avgLogprob > best.avgLogprob)) {
+            best = candidate;
+            best.strategy = attempt.strategy;
+            bestRatio = attempt.compressionRatio;
+            haveBest = true;
+        }
+
+        if (attempt.accepted) {
+            break;
+        }
+    }
+
+    best.fullContextFallback = haveBest && audioCtx > 0 && best.audioCtx == 0;
+    best.attempts = attempts;
+    best.budgetExhausted = budgetExhausted;
+
+    // Per-utterance report: every pass with its cost and verdict
+    std::string report = "Decode report (" + std::to_string(audioSeconds).substr(0, 4) + " s audio): ";
+    double totalMs = 0.0;
+    for (size_t i = 0; i < attempts.size(); i++) {
+        const DecodeAttempt& attempt = attempts[i];
+        totalMs += attempt.ms;
+        report += (i > 0 ? " -> " : "") + attempt.strategy +
+                  (attempt.audioCtx > 0 ? " ctx" + std::to_string(attempt.audioCtx) : "") +
+                  " " + std::to_string(static_cast<int>(attempt.ms)) + " ms" +
+                  " lp " + std::to_string(attempt.avgLogprob).substr(0, 5) +
+                  " cr " + std::to_string(attempt.compressionRatio).substr(0, 4) +
+                  (attempt.accepted ? " ok" : " retry");
+    }
+    report += "; used " + (haveBest ? best.strategy : std::string("none")) + ", " +
+              std::to_string(static_cast<int>(totalMs)) + " ms";
+    if (adaptive.latencyBudgetMs > 0) {
+        report += " of " + std::to_string(adaptive.latencyBudgetMs) + " ms budget";
+    }
+    if (budgetExhausted) {
+        report += " (budget exhausted)";
+    }
+    if (noSpeech) {
+        report += " (no speech, p " + std::to_string(best.noSpeechProb).substr(0, 4) + ")";
+    }
+    Logger::info(report);
+    return best;
+}
+
+SpeechGateVerdict Transcription::checkSpeechGate(const std::vector<float>& audioData, float voicedThreshold) {
+    const Settings::SpeechGateSettings& gate = settings.speechGate;
+    if (!gate.enabled) {
+        return SpeechGateVerdict::SPEECH;
+    }
+
+    // Frames count as voiced by the level of the mode that produced the chunk: the speech
+    // detector's threshold for continuous chunks, silence_threshold for push-to-talk
+    if (voicedThreshold <= 0.0f) {
+        voicedThreshold = settings.speechDetection.threshold;
+    }
+    VoicingStats voicing = measureVoicing(audioData.data(), audioData.size(), WHISPER_SAMPLE_RATE,
+                                          voicedThreshold,
+                                          settings.speechDetection.maxZeroCrossingRate);
+    SpeechGateVerdict verdict = SpeechGateVerdict::SPEECH;
+    if (voicing.rms < gate.minRms) {
+        verdict = SpeechGateVerdict::LOW_ENERGY;
+    } else if (voicing.voicedFrames * 20 < gate.minVoicedMs ||
+               voicing.voicedFrames < gate.minVoicedRatio * voicing.frames) {
+        verdict = SpeechGateVerdict::UNVOICED;
+    }
+
+    std::lock_guard<std::mutex> lock(costMutex);
+    gateStats.checked++;
+    if (verdict == SpeechGateVerdict::LOW_ENERGY) {
+        gateStats.lowEnergy++;
+    } else if (verdict == SpeechGateVerdict::UNVOICED) {
+        gateStats.unvoiced++;
+    }
+    if (verdict != SpeechGateVerdict::SPEECH) {
+        gateStats.skippedAudioSeconds += static_cast<double>(audioData.size()) / WHISPER_SAMPLE_RATE;
+    }
+    return verdict;
+}
+
+// Whisper's own rule: likely silence, and the text it produced anyway is unconfident
+bool Transcription::isNoSpeech(float noSpeechProb, float avgLogprob) const {
+    return settings.speechGate.enabled && noSpeechProb > settings.speechGate.noSpeechThreshold &&
+           avgLogprob < settings.speechGate.logprobThreshold;
+}
+
+float noSpeechProbability(const float* logits, int vocabSize, whisper_token noSpeechToken) {
+    if (!logits || noSpeechToken < 0 || noSpeechToken >= vocabSize) {
+        return 0.0f;
+    }
+    float maxLogit = *std::max_element(logits, logits + vocabSize);
+    double sum = 0.0;
+    for (int i = 0; i < vocabSize; i++) {
+        sum += std::exp(static_cast<double>(logits[i] - maxLogit));
+    }
+    return static_cast<float>(std::exp(static_cast<double>(logits[noSpeechToken] - maxLogit)) / sum);
+}
+
+std::string Transcription::strategyName(const DecodeOptions& options) const {
+    std::string name = "greedy";
+    if (options.sampling == WHISPER_SAMPLING_BEAM_SEARCH) {
+        name = "beam" + std::to_string(settings.beamSize);
+    } else if (options.temperature > 0.0f) {
+        name = "temp" + std::to_string(options.temperature).substr(0, 3);
+    }
+    return options.grammar ? name + "+grammar" : name;
+}
+
+Transcription::CostClass Transcription::costClass(const DecodeOptions& options) const {
+    if (options.sampling == WHISPER_SAMPLING_BEAM_SEARCH) {
+        return COST_BEAM;
+    }
+    return options.temperature > 0.0f ? COST_TEMPERATURE : COST_GREEDY;
+}
+
+// Expected time for a pass: the observed average for its class, or a multiple of this
+// utterance's first pass until there is data
+double Transcription::estimateCostMs(Model& model, const DecodeOptions& options, double audioSeconds,
+                                     double firstPassMs) {
+    CostClass cost = costClass(options);
+    {
+        std::lock_guard<std::mutex> lock(costMutex);
+        if (model.costMsPerSecond[cost] > 0.0) {
+            return model.costMsPerSecond[cost] * std::max(audioSeconds, 1.0);
+        }
+    }
+    return cost == COST_BEAM ? firstPassMs * 2.0 : firstPassMs;
+}
+
+void Transcription::recordCost(Model& model, const DecodeOptions& options, double audioSeconds, double ms) {
+    CostClass cost = costClass(options);
+    double msPerSecond = ms / std::max(audioSeconds, 1.0);
+    std::lock_guard<std::mutex> lock(costMutex);
+    double& average = model.costMsPerSecond[cost];
+    average = average > 0.0 ? 0.8 * average + 0.2 * msPerSecond : msPerSecond;
+}
+
+// What whisper's abort callback looks at during one pass
+struct AbortCheck {
+    const CancellationToken* cancel;
+    const std::atomic<bool>* aborting;
+    float earlyStopThreshold;     // No-speech probability that stops the pass, 0 = never
+    float noSpeechProb;           // Read at the first decoding step
+    bool noSpeech;                // Stopped because noSpeechProb passed the threshold
+};
+
+static bool abortRequested(void* data) {
+    const AbortCheck* check = static_cast<const AbortCheck*>(data);
+    return check->aborting->load() || check->noSpeech || (check->cancel && check->cancel->isCancelled());
+}
+
+// Called by whisper before it samples each token. At a window's first step the state's
+// logits are still the raw ones whisper takes its own no-speech probability from (its
+// filtering works on a copy), so the pass can be stopped before any text is decoded.
+static void checkFirstStep(whisper_context* ctx, whisper_state* state, const whisper_token_data* tokens,
+                           int tokenCount, float* logits, void* data) {
+    (void)tokens;
+    (void)logits;
+    AbortCheck* check = static_cast<AbortCheck*>(data);
+    if (tokenCount > 0 || check->noSpeech) {
+        return;
+    }
+    check->noSpeechProb = noSpeechProbability(whisper_get_logits_from_state(state), whisper_n_vocab(ctx),
+                                              whisper_token_nosp(ctx));
+    check->noSpeech = check->noSpeechProb > check->earlyStopThreshold;
+}
+
+// Run one whisper_full pass with the given sampling options
+bool Transcription::decode(Model& model, whisper_state* state, const std::vector<float>& audioData,
+                           const DecodeOptions& options, const std::vector<whisper_token>& prompt,
+                           TranscriptionResult& result) {
+    TRACE_SCOPE("Transcription::decode");
+    struct whisper_full_params params = whisper_full_default_params(options.sampling);
     params.language = settings.language.c_str();
     params.translate = settings.translate;
-    params.n_threads = settings.threads;
-    // Note: beam_size may need to be set differently; see notes below
-    // params.beam_search.beam_size = settings.beamSize;  // Example if using beam search
+    params.n_threads = model.threadsPerDecoder;
+    params.audio_ctx = options.audioCtx;
+    if (options.sampling == WHISPER_SAMPLING_BEAM_SEARCH) {
+        params.beam_search.beam_size = settings.beamSize;
+    }
+    params.temperature = options.temperature;
+    if (!options.whisperFallback) {
+        params.temperature_inc = 0.0f;
+    }
+
+    // States are shared by unrelated chunks, so never reuse a state's own past text;
+    // context only comes from the explicit prompt
+    params.no_context = true;
+    if (!prompt.empty()) {
+        params.prompt_tokens = prompt.data();
+        params.prompt_n_tokens = static_cast<int>(prompt.size());
+    }
+
+    // Commands are one short phrase: no timestamps or segment splits to decode
+    if (options.grammar) {
+        params.grammar_rules = options.grammar->rules();
+        params.n_grammar_rules = options.grammar->ruleCount();
+        params.i_start_rule = options.grammar->startRule();
+        params.grammar_penalty = settings.commandGrammar.penalty;
+        params.no_timestamps = true;
+        params.single_segment = true;
+    }
+
+    // Batched clips are split back up by token time
+    if (options.tokenTimestamps) {
+        params.token_timestamps = true;
+    }
 
-    if (whisper_full(ctx, params, audioData.data(), audioData.size()) != 0) {
-        Logger::error("Transcription failed");
-        return "";
+    // The speech gate applies whisper's no-speech rule itself, per segment, so whisper
+    // keeps every window and the probabilities stay readable afterwards
+    if (settings.speechGate.enabled) {
+        params.no_speech_thold = 1.0f;
     }
 
-    // Extract and return the transcription text
-    std::string result;
-    int n_segments = whisper_full_n_segments(ctx);
+    // Let cancellation (or shutdown) stop the decode between whisper's compute steps
+    AbortCheck abortCheck = {options.cancel, &aborting, 0.0f, 0.0f, false};
+    params.abort_callback = abortRequested;
+    params.abort_callback_user_data = &abortCheck;
+
+    // A clip that fits one window is stopped as soon as its first step is confidently
+    // silence. Longer clips (and packed batches, which hold several utterances) keep
+    // going and lose only their no-speech segments.
+    if (settings.speechGate.enabled && settings.speechGate.earlyStopThreshold > 0.0f && !options.tokenTimestamps &&
+        audioData.size() <= static_cast<size_t>(30 * WHISPER_SAMPLE_RATE)) {
+        abortCheck.earlyStopThreshold = settings.speechGate.earlyStopThreshold;
+        params.logits_filter_callback = checkFirstStep;
+        params.logits_filter_callback_user_data = &abortCheck;
+    }
+
+    // A spectrogram computed during capture replaces whisper's own extraction; it is padded
+    // past the audio, so bound the decode to the audio's length
+    const float* samples = audioData.data();
+    int sampleCount = static_cast<int>(audioData.size());
+    if (options.mel && options.mel->nMels == whisper_model_n_mels(model.ctx) &&
+        whisper_set_mel_with_state(model.ctx, state, options.mel->data.data(),
+                                   options.mel->nFrames, options.mel->nMels) == 0) {
+        params.duration_ms = static_cast<int>((audioData.size() * 1000 + WHISPER_SAMPLE_RATE - 1) / WHISPER_SAMPLE_RATE);
+        samples = nullptr;
+        sampleCount = 0;
+    }
+
+    int status = whisper_full_with_state(model.ctx, state, params, samples, sampleCount);
+    bool stoppedEarly = abortCheck.noSpeech && !aborting.load() && !(options.cancel && options.cancel->isCancelled());
+    if (stoppedEarly) {
+        // Nothing worth keeping was decoded; the pass succeeded in finding silence
+        Logger::info("No speech (probability " + std::to_string(abortCheck.noSpeechProb).substr(0, 4) +
+                     ") at the first decoding step, stopped the pass");
+        {
+            std::lock_guard<std::mutex> lock(costMutex);
+            gateStats.earlyStops++;
+        }
+        result.noSpeechProb = abortCheck.noSpeechProb;
+        result.gate = SpeechGateVerdict::NO_SPEECH;
+        result.audioCtx = options.audioCtx;
+        result.promptTokens = static_cast<int>(prompt.size());
+        result.success = true;
+        return true;
+    }
+    if (status != 0) {
+        if (!abortRequested(&abortCheck)) {
+            Logger::error("Transcription failed");
+        }
+        return false;
+    }
+
+    // Extract the text and average the log probability of the text tokens. A segment
+    // whisper thinks is silence and decoded without confidence is dropped on its own,
+    // so a silent stretch of a long clip doesn't cost the rest of the text.
+    const whisper_token eot = whisper_token_eot(model.ctx);
+    double logprobSum = 0.0;
+    int tokenCount = 0;
+    int n_segments = whisper_full_n_segments_from_state(state);
     for (int i = 0; i < n_segments; ++i) {
-        const char* text = whisper_full_get_segment_text(ctx, i);
-        result += text;
+        std::vector<whisper_token_data> segmentTokens;
+        std::vector<int> tokenIndices;
+        double segmentLogprobSum = 0.0;
+        int n_tokens = whisper_full_n_tokens_from_state(state, i);
+        for (int j = 0; j < n_tokens; ++j) {
+            whisper_token_data token = whisper_full_get_token_data_from_state(state, i, j);
+            if (token.id < eot) {
+                segmentLogprobSum += token.plog;
+                segmentTokens.push_back(token);
+                tokenIndices.push_back(j);
+            }
+        }
+
+        const char* text = whisper_full_get_segment_text_from_state(state, i);
+        float noSpeechProb = whisper_full_get_segment_no_speech_prob_from_state(state, i);
+        result.noSpeechProb = std::max(result.noSpeechProb, noSpeechProb);
+        if (!segmentTokens.empty() &&
+            isNoSpeech(noSpeechProb, static_cast<float>(segmentLogprobSum / segmentTokens.size()))) {
+            Logger::info("No speech (probability " + std::to_string(noSpeechProb).substr(0, 4) +
+                         "), dropping segment \"" + text + "\"");
+            result.noSpeechSegments++;
+            continue;
+        }
+
+        result.text += text;
+        logprobSum += segmentLogprobSum;
+        tokenCount += static_cast<int>(segmentTokens.size());
+        for (size_t k = 0; k < segmentTokens.size(); ++k) {
+            const whisper_token_data& token = segmentTokens[k];
+            result.tokens.push_back(token.id);
+            if (options.tokenTimestamps) {
+                TimedToken timed;
+                timed.id = token.id;
+                timed.text = whisper_full_get_token_text_from_state(model.ctx, state, i, tokenIndices[k]);
+                timed.t0 = token.t0;
+                timed.t1 = token.t1;
+                result.timedTokens.push_back(timed);
+            }
+        }
     }
-    return result;
+
+    // Only silence was decoded
+    if (result.noSpeechSegments > 0 && tokenCount == 0) {
+        result.gate = SpeechGateVerdict::NO_SPEECH;
+    }
+    result.audioCtx = options.audioCtx;
+    result.promptTokens = static_cast<int>(prompt.size());
+    result.avgLogprob = tokenCount > 0 ? static_cast<float>(logprobSum / tokenCount) : 0.0f;
+    result.success = true;
+    return true;
 }
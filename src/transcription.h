@@ -2,20 +2,316 @@
 #define TRANSCRIPTION_H
 
 #include "settings.h"
+#include "command_grammar.h"
+#include "audio_chunk.h"
 #include <whisper.h>
 #include <vector>
 #include <string>
+#include <deque>
+#include <utility>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+// Which model an utterance was sent to
+enum class TranscriptionRoute {
+    MAIN,  // Primary model, used for dictation
+    FAST   // Optional small model for mouse mode and short commands
+};
+
+// Running totals for one route
+struct RouteStats {
+    uint64_t utterances = 0;
+    double audioSeconds = 0.0;
+    double inferenceMs = 0.0;
+    double queueMs = 0.0;
+    uint64_t cancelled = 0;      // Jobs dropped or aborted after being cancelled
+    double wastedMs = 0.0;       // Inference time spent on jobs that were then aborted
+    uint64_t batches = 0;        // Passes that decoded several utterances at once
+    uint64_t batchedUtterances = 0;
+    uint64_t splitRecordings = 0;  // Long recordings decoded as concurrent windows (each window is an utterance)
+};
+
+// Why a chunk was or wasn't treated as speech
+enum class SpeechGateVerdict {
+    SPEECH,      // Decoded normally
+    LOW_ENERGY,  // Skipped before inference: too quiet overall
+    UNVOICED,    // Skipped before inference: too few frames that sound like speech
+    NO_SPEECH    // Every segment had a high no-speech probability and unconfident text
+};
+
+// Running totals for the speech gate
+struct SpeechGateStats {
+    uint64_t checked = 0;         // Chunks examined before inference
+    uint64_t lowEnergy = 0;
+    uint64_t unvoiced = 0;
+    uint64_t noSpeech = 0;        // Dropped after the first pass, escalation skipped
+    uint64_t earlyStops = 0;      // First passes stopped after whisper's first decoding step
+    uint64_t noSpeechSegments = 0;  // Segments dropped from text that was otherwise kept
+    double skippedAudioSeconds = 0.0;  // Audio never sent to whisper
+};
+
+// Energy and voicing of a clip, measured in 20 ms frames
+struct VoicingStats {
+    float rms = 0.0f;
+    int voicedFrames = 0;         // Frames above the speech threshold and not noise-like
+    int frames = 0;
+};
+VoicingStats measureVoicing(const float* samples, size_t count, int sampleRate,
+                            float frameThreshold, float maxZeroCrossingRate);
+
+// Shared flag that cancels every job submitted with it; cheap to copy. Queued jobs
+// are dropped and a running decode is aborted at whisper's next abort check.
+class CancellationToken {
+public:
+    CancellationToken() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() { flag->store(true); }
+    bool isCancelled() const { return flag->load(); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag;
+};
+
+// One whisper pass made while transcribing an utterance
+struct DecodeAttempt {
+    std::string strategy;        // e.g. "greedy", "beam5", "temp0.4"
+    int audioCtx = 0;
+    double ms = 0.0;
+    float avgLogprob = 0.0f;
+    float compressionRatio = 0.0f;
+    bool accepted = false;       // Passed the logprob and compression checks
+};
+
+// A decoded text token with its time in the clip (10 ms units)
+struct TimedToken {
+    whisper_token id = 0;
+    std::string text;
+    int64_t t0 = 0;
+    int64_t t1 = 0;
+};
+
+// Outcome of one transcription job
+struct TranscriptionResult {
+    std::string text;
+    bool success = false;
+    TranscriptionRoute route = TranscriptionRoute::MAIN;
+    double audioSeconds = 0.0;   // Length of the submitted audio
+    double queueMs = 0.0;        // Time waiting for the worker
+    double inferenceMs = 0.0;    // Time spent in whisper
+    int audioCtx = 0;            // Encoder context used, 0 = full 30 s window
+    float avgLogprob = 0.0f;     // Mean log probability of the text tokens
+    bool fullContextFallback = false;  // Re-decoded with full context after low confidence
+    int promptTokens = 0;        // Context tokens passed as the prompt
+    std::vector<whisper_token> tokens;  // Decoded text tokens, for commitContext()
+    std::string strategy;        // Strategy that produced the text
+    std::vector<DecodeAttempt> attempts;  // Every pass made, in order
+    bool budgetExhausted = false;  // Escalation stopped by the latency budget
+    bool cancelled = false;      // Cancelled before or during decoding; text is empty
+    SpeechGateVerdict gate = SpeechGateVerdict::SPEECH;  // Anything else means empty text
+    float noSpeechProb = 0.0f;   // Highest no-speech probability among the segments
+    int noSpeechSegments = 0;    // Segments dropped by the no-speech rule
+    int batchSize = 1;           // Utterances decoded in the same pass (inferenceMs is shared)
+    int splitParts = 1;          // Windows a long recording was split into and decoded concurrently
+    std::vector<std::pair<double, double>> failedSpans;  // Split windows (start, end s) whose text is missing
+    std::vector<TimedToken> timedTokens;  // Only for passes that asked for token timestamps
+    ChunkTiming timing;          // The chunk's timestamps through decodeEnd; callers add the rest
+};
+
+// Encoder context for a clip: 50 frames per second of audio plus margin, rounded up
+// to the granularity. Returns 0 (full context) once the clip needs the whole window.
+int computeAudioCtx(size_t sampleCount, int sampleRate, int marginMs, int granularity);
+
+// Probability whisper gives its no-speech token, from the logits of the step before
+// the first text token (softmax over the whole vocabulary)
+float noSpeechProbability(const float* logits, int vocabSize, whisper_token noSpeechToken);
+
+// Cut points for splitting a 16 kHz recording into windows for concurrent decoders;
+// empty when it should be decoded whole
+std::vector<size_t> planSplit(const std::vector<float>& audioData, size_t decoders,
+                              const Settings::ParallelSplitSettings& split);
 
 class Transcription {
 public:
     Transcription(const Settings& settings);
     ~Transcription();
+
+    // Start loading the model(s) on a background thread and return immediately.
+    // Jobs submitted meanwhile are queued and decoded once the model is ready.
     bool init();
+
+    // Main model loaded and warmed up / main model failed to load
+    bool isReady() const;
+    bool hasFailed() const;
+
+    // Queue audio for an inference worker. Blocks only while the job queue is full;
+    // check canSubmit() with the same chunk and mode first to stay non-blocking. With
+    // useContext the committed context window is passed to whisper as prompt tokens. commandMode (mouse mode)
+    // and short utterances go to the fast model when one is configured and loaded.
+    // Cancelling the token drops the job or aborts its decode.
+    std::future<TranscriptionResult> submit(std::vector<float> audioData, bool useContext = false,
+                                            bool commandMode = false,
+                                            CancellationToken cancel = CancellationToken());
+
+    // Same, for a captured chunk; its precomputed spectrogram (if any) replaces
+    // whisper's own mel extraction when the band count matches the model. A long
+    // recording without context is split at quiet points into windows that are
+    // decoded concurrently; the future resolves once the joined text is ready. Its
+    // windows wait in their own backlog outside the bounded queue, so a split never blocks.
+    std::future<TranscriptionResult> submit(AudioChunk chunk, bool useContext = false, bool commandMode = false,
+                                            CancellationToken cancel = CancellationToken());
+
+    // True if the queue of the model this chunk routes to (for the given commandMode)
+    // has room, so submit() queues it at once
+    bool canSubmit(const AudioChunk& chunk, bool commandMode = false) const;
+
+    // Jobs queued or running
+    size_t pendingJobs() const;
+
+    // Synchronous convenience wrapper: submit and wait for the text
     std::string transcribe(const std::vector<float>& audioData);
 
+    // Append an accepted result's tokens to the rolling context window. Call in
+    // capture order; chunks already decoding keep the context they started with.
+    void commitContext(const TranscriptionResult& result);
+
+    // Forget the context window (mode changes, continuous mode start/stop)
+    void resetContext();
+
+    // Compile the command vocabulary into a grammar for commandMode decodes.
+    // Call before init(); the workers read the grammar without locking.
+    void setCommandGrammar(const CommandVocabulary& vocabulary);
+
+    // Per-route counters, and a log line summarizing both routes
+    RouteStats getRouteStats(TranscriptionRoute route) const;
+    SpeechGateStats getSpeechGateStats() const;
+    void logRouteStats() const;
+
 private:
+    struct SplitRecording;
+
+    struct Job {
+        std::vector<float> audio;
+        bool useContext = false;
+        bool commandMode = false;
+        MelFrames mel;
+        CancellationToken cancel;
+        std::promise<TranscriptionResult> promise;
+        ChunkTiming timing;  // Capture-side timestamps plus enqueue
+        bool tokenTimestamps = false;  // Packed batch: keep token times to split the text
+        std::shared_ptr<SplitRecording> split;  // Set for one window of a split recording
+        size_t splitIndex = 0;
+    };
+
+    // Windows of one long recording; the last window to finish joins the text and
+    // resolves the caller's future
+    struct SplitRecording {
+        std::mutex mutex;
+        std::vector<TranscriptionResult> parts;
+        std::vector<size_t> edges;  // Window i covers samples edges[i] to edges[i + 1]
+        ChunkTiming timing;
+        size_t remaining = 0;
+        std::promise<TranscriptionResult> promise;
+    };
+
+    enum class ModelState { LOADING, READY, FAILED };
+
+    // Cost classes for the latency estimates
+    enum CostClass { COST_GREEDY, COST_BEAM, COST_TEMPERATURE, COST_CLASS_COUNT };
+
+    // A loaded model with its own decoder states, workers and job queue
+    struct Model {
+        TranscriptionRoute route = TranscriptionRoute::MAIN;
+        std::string name;
+        std::string path;
+        int decoderCount = 1;
+        whisper_context* ctx = nullptr;
+        std::vector<whisper_state*> states;
+        int threadsPerDecoder = 1;
+        std::vector<std::thread> workers;
+        std::deque<Job> jobs;
+        std::deque<Job> splitJobs;  // Windows of split recordings, not bounded by maxQueuedJobs
+        std::condition_variable jobAvailable;
+        std::atomic<ModelState> state{ModelState::LOADING};
+
+        // Observed decode cost per second of audio for each cost class (running average)
+        double costMsPerSecond[COST_CLASS_COUNT] = {};
+
+        RouteStats stats;
+    };
+
+    void loaderLoop();
+    bool loadModel(Model& model);
+    void warmUp(Model& model, whisper_state* state);
+    void failQueuedJobs(Model& model);
+    void resolveJob(Job& job, TranscriptionResult result);
+    std::future<TranscriptionResult> submitSplit(Model& model, AudioChunk chunk,
+                                                 const std::vector<size_t>& cuts, CancellationToken cancel);
+    static TranscriptionResult joinSplit(SplitRecording& split);
+    void workerLoop(Model* model, whisper_state* state);
+    bool isBatchable(const Job& job) const;
+    void collectBatch(Model& model, std::vector<Job>& batch);
+    std::vector<TranscriptionResult> runBatch(Model& model, whisper_state* state, std::vector<Job>& batch);
+    bool routesToFast(size_t sampleCount, bool commandMode, bool preferFast) const;
+    Model& routeFor(size_t sampleCount, bool commandMode, bool preferFast);
+
+    // How a single whisper pass samples
+    struct DecodeOptions {
+        whisper_sampling_strategy sampling = WHISPER_SAMPLING_GREEDY;
+        int audioCtx = 0;
+        float temperature = 0.0f;
+        bool whisperFallback = true;   // Let whisper run its own temperature fallback
+        const CommandGrammar* grammar = nullptr;  // Constrain the output to the command language
+        const CancellationToken* cancel = nullptr;  // Abort the pass when this is cancelled
+        const MelFrames* mel = nullptr;  // Precomputed spectrogram, used instead of the samples
+        bool tokenTimestamps = false;  // Fill TranscriptionResult::timedTokens
+    };
+
+    TranscriptionResult runInference(Model& model, whisper_state* state, const Job& job);
+    TranscriptionResult runAdaptive(Model& model, whisper_state* state, const std::vector<float>& audioData,
+                                    const DecodeOptions& base, const std::vector<whisper_token>& prompt);
+    bool decode(Model& model, whisper_state* state, const std::vector<float>& audioData,
+                const DecodeOptions& options, const std::vector<whisper_token>& prompt,
+                TranscriptionResult& result);
+    SpeechGateVerdict checkSpeechGate(const std::vector<float>& audioData, float voicedThreshold);
+    bool isNoSpeech(float noSpeechProb, float avgLogprob) const;
+    std::string strategyName(const DecodeOptions& options) const;
+    CostClass costClass(const DecodeOptions& options) const;
+    double estimateCostMs(Model& model, const DecodeOptions& options, double audioSeconds, double firstPassMs);
+    void recordCost(Model& model, const DecodeOptions& options, double audioSeconds, double ms);
+
     const Settings& settings;
-    whisper_context* ctx;
+    std::thread loader;
+
+    // Main model and the optional fast model; each decoder state shares its model's weights
+    Model mainModel;
+    Model fastModel;
+    bool fastModelEnabled = false;
+    std::atomic<bool> fastContextCompatible{false};  // Same vocabulary, so prompt tokens carry over
+
+    // Command language for mouse-mode decodes, if one was set
+    std::unique_ptr<CommandGrammar> commandGrammar;
+
+    // Bounded job queues (one per model) drained by the worker threads
+    mutable std::mutex jobMutex;
+    std::condition_variable spaceAvailable;
+    size_t maxQueuedJobs;
+    size_t activeJobs = 0;
+    bool stopping = false;
+    std::atomic<bool> aborting{false};  // Shutdown: abort decodes in flight
+
+    // Guards the cost estimates and route stats of both models, and the gate stats
+    mutable std::mutex costMutex;
+    SpeechGateStats gateStats;
+
+    // Rolling window of committed text tokens
+    std::deque<whisper_token> contextTokens;
+    std::mutex contextMutex;
 };
 
 #endif // TRANSCRIPTION_H
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// Minimal checks for the unit tests: every failure is printed with its location and
+// counted, and main returns checkResult() so CTest sees a non-zero exit code
+static int checkFailures = 0;
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            checkFailures++;                                                            \
+        }                                                                               \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tolerance)                                                     \
+    do {                                                                                \
+        double checkA = (a), checkB = (b);                                              \
+        if (!(std::fabs(checkA - checkB) <= (tolerance))) {                             \
+            std::fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %g vs %g\n",        \
+                         __FILE__, __LINE__, #a, #b, checkA, checkB);                   \
+            checkFailures++;                                                            \
+        }                                                                               \
+    } while (0)
+
+static int checkResult(const char* name) {
+    if (checkFailures > 0) {
+        std::fprintf(stderr, "%s: %d check(s) failed\n", name, checkFailures);
+        return 1;
+    }
+    std::printf("%s: all checks passed\n", name);
+    return 0;
+}
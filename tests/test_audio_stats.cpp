@@ -0,0 +1,83 @@
+// The vectorized block statistics kernel against the scalar reference, and the quiet
+// frame search built on it
+#include "audio_stats.h"
+#include "check.h"
+#include <random>
+#include <vector>
+
+static void checkMatchesScalar(const float* samples, size_t count) {
+    AudioBlockStats fast = computeBlockStats(samples, count);
+    AudioBlockStats reference = computeBlockStatsScalar(samples, count);
+    CHECK(fast.sampleCount == reference.sampleCount);
+    CHECK(fast.zeroCrossings == reference.zeroCrossings);
+    CHECK(fast.peak == reference.peak);
+    CHECK_NEAR(fast.sumSquares, reference.sumSquares, 1e-9 * (1.0 + reference.sumSquares));
+    CHECK_NEAR(fast.rms(), reference.rms(), 1e-6);
+    CHECK_NEAR(fast.zeroCrossingRate(), reference.zeroCrossingRate(), 1e-6);
+}
+
+static void testKernelMatchesScalar() {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    std::vector<float> samples(4096 + 64);
+    for (float& sample : samples) {
+        sample = noise(rng);
+    }
+    // Exact zeros and sign runs exercise the zero-crossing rule
+    for (size_t i = 100; i < 140; i++) {
+        samples[i] = 0.0f;
+    }
+    for (size_t i = 200; i < 260; i++) {
+        samples[i] = 0.25f;
+    }
+    samples[300] = -1.0f;
+
+    // Every length up to a few vectors covers the tail handling, and odd offsets
+    // cover unaligned loads
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t count = 0; count <= 70; count++) {
+            checkMatchesScalar(samples.data() + offset, count);
+        }
+    }
+    checkMatchesScalar(samples.data(), 4096);
+    checkMatchesScalar(samples.data() + 3, 4096 + 61);
+}
+
+static void testKnownValues() {
+    const float samples[] = {0.5f, -0.5f, 0.5f, -0.5f};
+    AudioBlockStats stats = computeBlockStats(samples, 4);
+    CHECK(stats.sampleCount == 4);
+    CHECK(stats.zeroCrossings == 3);
+    CHECK_NEAR(stats.peak, 0.5, 1e-7);
+    CHECK_NEAR(stats.rms(), 0.5, 1e-6);
+
+    AudioBlockStats empty = computeBlockStats(samples, 0);
+    CHECK(empty.sampleCount == 0);
+    CHECK(empty.rms() == 0.0f);
+}
+
+static void testFindQuietestFrame() {
+    const size_t frame = 320;
+    std::vector<float> samples(16000, 0.3f);
+    for (size_t i = 8000; i < 8000 + frame; i++) {
+        samples[i] = 0.01f;
+    }
+    CHECK(findQuietestFrame(samples.data(), 0, samples.size(), frame) == 8000);
+    CHECK(findQuietestFrame(samples.data(), 4000, 12000, frame) == 8000);
+
+    // Outside the quiet stretch every frame ties, and ties go to the last one searched
+    // (half-frame steps from 0, so 3680 is the last start that fits before 4000)
+    CHECK(findQuietestFrame(samples.data(), 0, 4000, frame) == 3680);
+
+    // No whole frame fits
+    CHECK(findQuietestFrame(samples.data(), 100, 100 + frame - 1, frame) == 100);
+    CHECK(findQuietestFrame(nullptr, 5, 5000, frame) == 5);
+}
+
+int main() {
+    std::printf("block statistics kernel: %s\n", blockStatsKernelName());
+    testKernelMatchesScalar();
+    testKnownValues();
+    testFindQuietestFrame();
+    return checkResult("test_audio_stats");
+}
@@ -0,0 +1,103 @@
+// The push-to-talk capture store: memory limit, dropping, spilling to a file, and
+// recovery after a failed spill
+#include "capture_store.h"
+#include "check.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+static std::vector<float> ramp(size_t start, size_t count) {
+    std::vector<float> samples(count);
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = static_cast<float>(start + i);
+    }
+    return samples;
+}
+
+static bool isRamp(const std::vector<float>& samples, size_t count) {
+    if (samples.size() != count) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (samples[i] != static_cast<float>(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testDropsPastMemoryLimit() {
+    CaptureStore store;
+    store.configure(1000, false, 0, "");
+    std::vector<float> block = ramp(0, 600);
+    CHECK(store.append(block.data(), block.size()) == 600);
+    block = ramp(600, 600);
+    CHECK(store.append(block.data(), block.size()) == 400);
+    CHECK(store.size() == 1000);
+    CHECK(store.droppedSamples() == 200);
+    CHECK(!store.isSpilled());
+    CHECK(isRamp(store.data(), 1000));
+
+    float range[3] = {};
+    store.copyRange(500, 3, range);
+    CHECK(range[0] == 500.0f && range[2] == 502.0f);
+
+    store.clear();
+    CHECK(store.empty());
+    CHECK(store.droppedSamples() == 0);
+    CHECK(store.peakBytes() >= 1000 * sizeof(float));
+}
+
+static void testSpillsToFile() {
+    CaptureStore store;
+    store.configure(1000, true, 100000, ".");
+    size_t total = 0;
+    for (int i = 0; i < 50; i++) {
+        std::vector<float> block = ramp(total, 997);
+        total += store.append(block.data(), block.size());
+    }
+    CHECK(total == 50 * 997);
+    CHECK(store.isSpilled());
+    CHECK(store.droppedSamples() == 0);
+    CHECK(isRamp(store.data(), total));
+
+    float range[4] = {};
+    store.copyRange(40000, 4, range);
+    CHECK(range[0] == 40000.0f && range[3] == 40003.0f);
+
+    // The spill limit still applies
+    std::vector<float> block = ramp(total, 60000);
+    CHECK(store.append(block.data(), block.size()) == 100000 - total);
+
+    store.clear();
+    CHECK(!store.isSpilled());
+    CHECK(store.empty());
+}
+
+static void testRetriesAfterFailedSpill() {
+    // The spill directory doesn't exist yet, so the first recording can't spill
+    const std::string spillDir = "test_capture_spill_dir";
+    std::filesystem::remove_all(spillDir);
+    CaptureStore store;
+    store.configure(100, true, 10000, spillDir);
+    std::vector<float> block = ramp(0, 300);
+    CHECK(store.append(block.data(), block.size()) == 100);
+    CHECK(!store.isSpilled());
+    CHECK(store.droppedSamples() == 200);
+
+    // The next recording tries again and succeeds once the directory is there
+    store.clear();
+    std::filesystem::create_directory(spillDir);
+    CHECK(store.append(block.data(), block.size()) == 300);
+    CHECK(store.isSpilled());
+    CHECK(isRamp(store.data(), 300));
+    store.clear();
+    std::filesystem::remove_all(spillDir);
+}
+
+int main() {
+    testDropsPastMemoryLimit();
+    testSpillsToFile();
+    testRetriesAfterFailedSpill();
+    return checkResult("test_capture_store");
+}
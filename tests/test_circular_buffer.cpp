@@ -0,0 +1,74 @@
+// The pre-speech buffer: keeps the most recent samples, oldest first, across wraps
+#include "circular_buffer.h"
+#include "check.h"
+#include <vector>
+
+static std::vector<int> contents(const CircularBuffer<int>& buffer) {
+    CircularBuffer<int>::View view = buffer.view();
+    std::vector<int> out(view.first, view.first + view.firstSize);
+    out.insert(out.end(), view.second, view.second + view.secondSize);
+    return out;
+}
+
+static void testKeepsMostRecent() {
+    CircularBuffer<int> buffer(5);
+    CHECK(buffer.empty());
+    CHECK(buffer.view().size() == 0);
+
+    const int first[] = {1, 2, 3};
+    buffer.push(first, 3);
+    CHECK(contents(buffer) == std::vector<int>({1, 2, 3}));
+
+    // Overwrites the oldest and wraps: the view splits into two spans
+    const int second[] = {4, 5, 6, 7};
+    buffer.push(second, 4);
+    CHECK(buffer.size() == 5);
+    CHECK(buffer.view().secondSize > 0);
+    CHECK(contents(buffer) == std::vector<int>({3, 4, 5, 6, 7}));
+
+    // A block larger than the buffer keeps only its tail
+    const int big[] = {10, 11, 12, 13, 14, 15, 16};
+    buffer.push(big, 7);
+    CHECK(contents(buffer) == std::vector<int>({12, 13, 14, 15, 16}));
+
+    buffer.clear();
+    CHECK(buffer.empty());
+    buffer.push(first, 2);
+    CHECK(contents(buffer) == std::vector<int>({1, 2}));
+}
+
+static void testMatchesNaiveHistory() {
+    CircularBuffer<int> buffer(37);
+    std::vector<int> history;
+    std::vector<int> block;
+    int next = 0;
+    for (int round = 0; round < 200; round++) {
+        block.assign(round * 7 % 50, 0);
+        for (int& value : block) {
+            value = next++;
+        }
+        buffer.push(block.data(), block.size());
+        history.insert(history.end(), block.begin(), block.end());
+
+        size_t keep = std::min<size_t>(history.size(), 37);
+        std::vector<int> expected(history.end() - keep, history.end());
+        CHECK(contents(buffer) == expected);
+    }
+}
+
+static void testZeroCapacity() {
+    CircularBuffer<int> buffer;
+    const int data[] = {1, 2};
+    buffer.push(data, 2);
+    CHECK(buffer.empty());
+    buffer.reset(3);
+    buffer.push(data, 2);
+    CHECK(contents(buffer) == std::vector<int>({1, 2}));
+}
+
+int main() {
+    testKeepsMostRecent();
+    testMatchesNaiveHistory();
+    testZeroCapacity();
+    return checkResult("test_circular_buffer");
+}
@@ -0,0 +1,123 @@
+// The mouse-mode grammar, run through a small matcher with whisper's grammar
+// semantics: which transcripts it accepts and which it rules out
+#include "command_grammar.h"
+#include "check.h"
+#include <set>
+#include <string>
+
+// A character class is CHAR or CHAR_NOT followed by CHAR_ALT / CHAR_RNG_UPPER elements
+static size_t charClassEnd(const whisper_grammar_element* rule, size_t i) {
+    do {
+        i += rule[i + 1].type == WHISPER_GRETYPE_CHAR_RNG_UPPER ? 2 : 1;
+    } while (rule[i].type == WHISPER_GRETYPE_CHAR_ALT);
+    return i;
+}
+
+static bool charClassMatches(const whisper_grammar_element* rule, size_t i, unsigned char c) {
+    bool negate = rule[i].type == WHISPER_GRETYPE_CHAR_NOT;
+    bool found = false;
+    do {
+        uint32_t lower = rule[i].value;
+        if (rule[i + 1].type == WHISPER_GRETYPE_CHAR_RNG_UPPER) {
+            found = found || (lower <= c && c <= rule[i + 1].value);
+            i += 2;
+        } else {
+            found = found || c == lower;
+            i++;
+        }
+    } while (rule[i].type == WHISPER_GRETYPE_CHAR_ALT);
+    return found != negate;
+}
+
+// End positions reachable by matching one rule from pos
+static std::set<size_t> matchRule(const CommandGrammar& grammar, size_t ruleIndex, const std::string& text,
+                                  size_t pos) {
+    const whisper_grammar_element* rule = grammar.rules()[ruleIndex];
+    std::set<size_t> ends;
+    size_t i = 0;
+    while (true) {
+        // One alternative: a sequence up to ALT or END
+        std::set<size_t> positions = {pos};
+        while (rule[i].type != WHISPER_GRETYPE_ALT && rule[i].type != WHISPER_GRETYPE_END) {
+            std::set<size_t> next;
+            if (rule[i].type == WHISPER_GRETYPE_RULE_REF) {
+                for (size_t at : positions) {
+                    std::set<size_t> sub = matchRule(grammar, rule[i].value, text, at);
+                    next.insert(sub.begin(), sub.end());
+                }
+                i++;
+            } else {
+                for (size_t at : positions) {
+                    if (at < text.size() && charClassMatches(rule, i, static_cast<unsigned char>(text[at]))) {
+                        next.insert(at + 1);
+                    }
+                }
+                i = charClassEnd(rule, i);
+            }
+            positions = next;
+        }
+        ends.insert(positions.begin(), positions.end());
+        if (rule[i].type == WHISPER_GRETYPE_END) {
+            return ends;
+        }
+        i++;
+    }
+}
+
+static bool accepts(const CommandGrammar& grammar, const std::string& text) {
+    return matchRule(grammar, grammar.startRule(), text, 0).count(text.size()) > 0;
+}
+
+static CommandVocabulary makeVocabulary() {
+    CommandVocabulary vocabulary;
+    vocabulary.phrases = {"Jarvis text mode", "click", "double-click"};
+    vocabulary.movementPhrases = {"left", "move up"};
+    vocabulary.keyPrefixes = {"jarvis press"};
+    vocabulary.keyNames = {"enter", "control", "c", "f5"};
+    return vocabulary;
+}
+
+static void testAcceptsCommands() {
+    CommandGrammar grammar(makeVocabulary());
+    CHECK(!grammar.empty());
+    CHECK(grammar.phraseCount() == 6);
+
+    CHECK(accepts(grammar, " Jarvis text mode."));
+    CHECK(accepts(grammar, " jarvis, text mode"));
+    CHECK(accepts(grammar, " CLICK!"));
+    CHECK(accepts(grammar, " double click"));
+    CHECK(accepts(grammar, " left"));
+    CHECK(accepts(grammar, " Left, 200."));
+    CHECK(accepts(grammar, " move up 15?"));
+    CHECK(accepts(grammar, " jarvis press enter"));
+    CHECK(accepts(grammar, " Jarvis press control, c."));
+    CHECK(accepts(grammar, " jarvis press control f5"));
+}
+
+static void testRejectsOtherText() {
+    CommandGrammar grammar(makeVocabulary());
+    CHECK(!accepts(grammar, "click"));
+    CHECK(!accepts(grammar, " hello world"));
+    CHECK(!accepts(grammar, " click click"));
+    CHECK(!accepts(grammar, " left two hundred"));
+    CHECK(!accepts(grammar, " click 200"));
+    CHECK(!accepts(grammar, " jarvis press"));
+    CHECK(!accepts(grammar, " jarvis press escape"));
+    CHECK(!accepts(grammar, " left,, 20"));
+}
+
+static void testEmptyVocabulary() {
+    CHECK(CommandGrammar(CommandVocabulary()).empty());
+
+    // Key prefixes are useless without key names
+    CommandVocabulary prefixesOnly;
+    prefixesOnly.keyPrefixes = {"jarvis press"};
+    CHECK(CommandGrammar(prefixesOnly).empty());
+}
+
+int main() {
+    testAcceptsCommands();
+    testRejectsOtherText();
+    testEmptyVocabulary();
+    return checkResult("test_command_grammar");
+}
@@ -0,0 +1,152 @@
+// WAV decoding through the file source: sample formats, downmixing and sign handling
+#include "file_audio_source.h"
+#include "check.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Collects everything a source delivers
+class CollectingSink : public AudioSink {
+public:
+    void pushRealtime(const float* samples, size_t count) override {
+        pushBlocking(samples, count);
+    }
+
+    size_t pushBlocking(const float* samples, size_t count) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.insert(received.end(), samples, samples + count);
+        return count;
+    }
+
+    void endOfStream() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        ended = true;
+        endedChanged.notify_all();
+    }
+
+    bool waitForEnd() {
+        std::unique_lock<std::mutex> lock(mutex);
+        return endedChanged.wait_for(lock, std::chrono::seconds(10), [this] { return ended; });
+    }
+
+    std::vector<float> received;
+
+private:
+    std::mutex mutex;
+    std::condition_variable endedChanged;
+    bool ended = false;
+};
+
+static void putLe(std::vector<uint8_t>& out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+static std::string writeWav(const std::string& name, int formatTag, int channels, int bits,
+                            const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> file;
+    const int rate = 16000;
+    const int blockAlign = channels * bits / 8;
+    file.insert(file.end(), {'R', 'I', 'F', 'F'});
+    putLe(file, static_cast<uint32_t>(36 + data.size()), 4);
+    file.insert(file.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    putLe(file, 16, 4);
+    putLe(file, formatTag, 2);
+    putLe(file, channels, 2);
+    putLe(file, rate, 4);
+    putLe(file, rate * blockAlign, 4);
+    putLe(file, blockAlign, 2);
+    putLe(file, bits, 2);
+    file.insert(file.end(), {'d', 'a', 't', 'a'});
+    putLe(file, static_cast<uint32_t>(data.size()), 4);
+    file.insert(file.end(), data.begin(), data.end());
+
+    std::FILE* out = std::fopen(name.c_str(), "wb");
+    std::fwrite(file.data(), 1, file.size(), out);
+    std::fclose(out);
+    return name;
+}
+
+static std::vector<float> decode(const std::string& path) {
+    CollectingSink sink;
+    WavFileSource source(path);
+    if (!source.open(16000, &sink)) {
+        return std::vector<float>();
+    }
+    source.start();
+    bool ended = sink.waitForEnd();
+    source.stop();
+    source.close();
+    std::remove(path.c_str());
+    CHECK(ended);
+    return sink.received;
+}
+
+static void test16BitStereo() {
+    // Left and right are averaged
+    std::vector<uint8_t> data;
+    const int16_t frames[][2] = {{16384, 16384}, {-32768, 0}, {1000, -1000}};
+    for (const auto& frame : frames) {
+        putLe(data, static_cast<uint16_t>(frame[0]), 2);
+        putLe(data, static_cast<uint16_t>(frame[1]), 2);
+    }
+    std::vector<float> samples = decode(writeWav("test_pcm16.wav", 1, 2, 16, data));
+    CHECK(samples.size() == 3);
+    if (samples.size() == 3) {
+        CHECK_NEAR(samples[0], 0.5, 1e-6);
+        CHECK_NEAR(samples[1], -0.5, 1e-6);
+        CHECK_NEAR(samples[2], 0.0, 1e-6);
+    }
+}
+
+static void test24BitSigns() {
+    const int32_t values[] = {0x400000, -0x400000, -0x800000, 0x7fffff, -1};
+    std::vector<uint8_t> data;
+    for (int32_t value : values) {
+        putLe(data, static_cast<uint32_t>(value) & 0xffffff, 3);
+    }
+    std::vector<float> samples = decode(writeWav("test_pcm24.wav", 1, 1, 24, data));
+    CHECK(samples.size() == 5);
+    if (samples.size() == 5) {
+        CHECK_NEAR(samples[0], 0.5, 1e-6);
+        CHECK_NEAR(samples[1], -0.5, 1e-6);
+        CHECK_NEAR(samples[2], -1.0, 1e-6);
+        CHECK_NEAR(samples[3], 1.0, 1e-6);
+        CHECK(samples[4] < 0.0f && samples[4] > -1e-6f);
+    }
+}
+
+static void testFloat32() {
+    const float values[] = {0.25f, -0.75f, 1.0f};
+    std::vector<uint8_t> data;
+    for (float value : values) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        putLe(data, bits, 4);
+    }
+    std::vector<float> samples = decode(writeWav("test_float.wav", 3, 1, 32, data));
+    CHECK(samples.size() == 3);
+    if (samples.size() == 3) {
+        CHECK(samples[0] == 0.25f && samples[1] == -0.75f && samples[2] == 1.0f);
+    }
+}
+
+static void testMissingFile() {
+    CollectingSink sink;
+    WavFileSource source("missing_test_file.wav");
+    CHECK(!source.open(16000, &sink));
+}
+
+int main() {
+    test16BitStereo();
+    test24BitSigns();
+    testFloat32();
+    testMissingFile();
+    return checkResult("test_file_audio_source");
+}
@@ -0,0 +1,166 @@
+// The incremental spectrogram, fed in random block sizes, against a direct batch
+// implementation of whisper.cpp's log_mel_spectrogram with the same filterbank
+#include "mel_spectrogram.h"
+#include "check.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+static const int N_FFT = 400;
+static const int HOP = 160;
+static const int BINS = 201;
+static const int N_MELS = 80;
+
+// Overlapping triangles with uneven heights, written as a ggml model file header
+static std::vector<float> makeFilters() {
+    std::vector<float> filters(N_MELS * BINS, 0.0f);
+    for (int m = 0; m < N_MELS; m++) {
+        int center = 2 + m * 5 / 2;
+        for (int k = center - 3; k <= center + 3; k++) {
+            if (k >= 0 && k < BINS) {
+                filters[m * BINS + k] = (4 - std::abs(k - center)) * (0.01f + 0.0005f * m);
+            }
+        }
+    }
+    return filters;
+}
+
+static std::string writeModelHeader(const std::vector<float>& filters, int nMels) {
+    std::string path = "test_mel_filters.bin";
+    std::ofstream file(path, std::ios::binary);
+    uint32_t magic = 0x67676d6c;
+    int32_t hparams[11] = {};
+    int32_t mels = nMels;
+    int32_t bins = BINS;
+    file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+    file.write(reinterpret_cast<const char*>(hparams), sizeof(hparams));
+    file.write(reinterpret_cast<const char*>(&mels), sizeof(mels));
+    file.write(reinterpret_cast<const char*>(&bins), sizeof(bins));
+    file.write(reinterpret_cast<const char*>(filters.data()),
+               static_cast<std::streamsize>(static_cast<size_t>(nMels) * BINS * sizeof(float)));
+    return path;
+}
+
+// whisper.cpp's extraction, one frame at a time with a double-precision DFT
+static MelFrames batchMel(const std::vector<float>& samples, const std::vector<float>& filters) {
+    const double pi = 3.14159265358979323846;
+    const size_t n = samples.size();
+    std::vector<float> padded(n + 30 * 16000 + 2 * (N_FFT / 2), 0.0f);
+    std::copy(samples.begin(), samples.end(), padded.begin() + N_FFT / 2);
+    std::reverse_copy(samples.begin() + 1, samples.begin() + 1 + N_FFT / 2, padded.begin());
+
+    MelFrames mel;
+    mel.nMels = N_MELS;
+    mel.nFrames = static_cast<int>((padded.size() - N_FFT) / HOP);
+    mel.data.assign(static_cast<size_t>(mel.nMels) * mel.nFrames, -10.0f);
+
+    const size_t signalEnd = n + N_FFT / 2;
+    const size_t fftFrames = std::min<size_t>(signalEnd / HOP + 1, mel.nFrames);
+    std::vector<double> power(BINS);
+    for (size_t t = 0; t < fftFrames; t++) {
+        size_t offset = t * HOP;
+        for (int k = 0; k < BINS; k++) {
+            double re = 0.0;
+            double im = 0.0;
+            for (int j = 0; j < N_FFT && offset + j < signalEnd; j++) {
+                double hann = 0.5 * (1.0 - std::cos(2.0 * pi * j / N_FFT));
+                double angle = 2.0 * pi * ((static_cast<long>(j) * k) % N_FFT) / N_FFT;
+                re += padded[offset + j] * hann * std::cos(angle);
+                im -= padded[offset + j] * hann * std::sin(angle);
+            }
+            power[k] = re * re + im * im;
+        }
+        for (int m = 0; m < N_MELS; m++) {
+            double sum = 0.0;
+            for (int k = 0; k < BINS; k++) {
+                sum += filters[m * BINS + k] * power[k];
+            }
+            mel.data[m * mel.nFrames + t] = static_cast<float>(std::log10(std::max(sum, 1e-10)));
+        }
+    }
+
+    float maxValue = *std::max_element(mel.data.begin(), mel.data.end());
+    for (float& value : mel.data) {
+        value = (std::max(value, maxValue - 8.0f) + 4.0f) / 4.0f;
+    }
+    return mel;
+}
+
+static std::vector<float> makeSignal(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 0.01f);
+    std::vector<float> samples(count);
+    for (size_t i = 0; i < count; i++) {
+        float envelope = (i / 4000) % 2 == 0 ? 1.0f : 0.2f;
+        samples[i] = envelope * (0.3f * std::sin(0.07f * i) + 0.1f * std::sin(0.31f * i)) + noise(rng);
+    }
+    return samples;
+}
+
+static void checkSameMel(const MelFrames& incremental, const MelFrames& batch) {
+    CHECK(incremental.nMels == batch.nMels);
+    CHECK(incremental.nFrames == batch.nFrames);
+    if (incremental.data.size() != batch.data.size()) {
+        return;
+    }
+    double maxDiff = 0.0;
+    for (size_t i = 0; i < batch.data.size(); i++) {
+        maxDiff = std::max(maxDiff, static_cast<double>(std::fabs(incremental.data[i] - batch.data[i])));
+    }
+    CHECK_NEAR(maxDiff, 0.0, 1e-4);
+}
+
+static void testIncrementalMatchesBatch(const std::string& modelPath, const std::vector<float>& filters) {
+    std::mt19937 rng(42);
+    for (size_t length : {201u, 1000u, 16000u, 37123u}) {
+        std::vector<float> samples = makeSignal(length, static_cast<unsigned>(length));
+        MelFrames batch = batchMel(samples, filters);
+
+        MelSpectrogram mel(N_MELS);
+        CHECK(mel.loadModelFilters(modelPath));
+        // The same clip twice checks that finish() leaves it ready for the next one
+        for (int pass = 0; pass < 2; pass++) {
+            std::uniform_int_distribution<size_t> blockSize(1, 2000);
+            size_t pos = 0;
+            while (pos < samples.size()) {
+                size_t count = std::min(blockSize(rng), samples.size() - pos);
+                mel.push(samples.data() + pos, count);
+                pos += count;
+            }
+            CHECK(mel.sampleCount() == samples.size());
+            size_t expectedBytes = mel.finishedBytes();
+            MelFrames incremental = mel.finish();
+            CHECK(incremental.data.size() * sizeof(float) <= expectedBytes);
+            checkSameMel(incremental, batch);
+            CHECK(mel.sampleCount() == 0);
+        }
+    }
+}
+
+static void testShortClip() {
+    // Whisper needs 201 samples for its reflection padding
+    MelSpectrogram mel(N_MELS);
+    std::vector<float> samples(200, 0.1f);
+    mel.push(samples.data(), samples.size());
+    CHECK(mel.finish().empty());
+}
+
+static void testModelFilterValidation(const std::vector<float>& filters) {
+    MelSpectrogram wideMel(128);
+    CHECK(!wideMel.loadModelFilters(writeModelHeader(filters, N_MELS)));
+    CHECK(!wideMel.loadModelFilters("missing_model_file.bin"));
+}
+
+int main() {
+    std::vector<float> filters = makeFilters();
+    std::string modelPath = writeModelHeader(filters, N_MELS);
+    testIncrementalMatchesBatch(modelPath, filters);
+    testShortClip();
+    testModelFilterValidation(filters);
+    std::remove(modelPath.c_str());
+    return checkResult("test_mel_spectrogram");
+}
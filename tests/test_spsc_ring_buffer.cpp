@@ -0,0 +1,75 @@
+// The lock-free capture ring: capacity rounding, wrap-around, overflow, and a real
+// producer/consumer pair that must see every sample exactly once, in order
+#include "ring_buffer.h"
+#include "check.h"
+#include <thread>
+#include <vector>
+
+static void testWrapAndOverflow() {
+    SpscRingBuffer<float> ring(6);
+    CHECK(ring.capacity() == 8);
+    CHECK(ring.available() == 0);
+
+    float in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    float out[10] = {};
+    CHECK(ring.write(in, 5) == 5);
+    CHECK(ring.read(out, 3) == 3);
+    CHECK(out[0] == 0.0f && out[2] == 2.0f);
+
+    // Wraps past the end of storage; only the free space is taken
+    CHECK(ring.write(in + 5, 5) == 5);
+    CHECK(ring.available() == 7);
+    CHECK(ring.write(in, 3) == 1);
+    CHECK(ring.available() == 8);
+
+    CHECK(ring.read(out, 10) == 8);
+    const float expected[8] = {3, 4, 5, 6, 7, 8, 9, 0};
+    for (int i = 0; i < 8; i++) {
+        CHECK(out[i] == expected[i]);
+    }
+    CHECK(ring.read(out, 10) == 0);
+}
+
+static void testProducerConsumer() {
+    const int total = 1000000;
+    SpscRingBuffer<int> ring(1024);
+
+    std::thread producer([&ring, total] {
+        std::vector<int> block(97);
+        int next = 0;
+        while (next < total) {
+            int count = std::min<int>(static_cast<int>(block.size()), total - next);
+            for (int i = 0; i < count; i++) {
+                block[i] = next + i;
+            }
+            int written = static_cast<int>(ring.write(block.data(), count));
+            next += written;
+            if (written == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::vector<int> block(61);
+    int expected = 0;
+    bool inOrder = true;
+    while (expected < total) {
+        size_t count = ring.read(block.data(), block.size());
+        for (size_t i = 0; i < count; i++) {
+            inOrder = inOrder && block[i] == expected;
+            expected++;
+        }
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    CHECK(inOrder);
+    CHECK(ring.available() == 0);
+}
+
+int main() {
+    testWrapAndOverflow();
+    testProducerConsumer();
+    return checkResult("test_spsc_ring_buffer");
+}
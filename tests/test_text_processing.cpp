@@ -0,0 +1,65 @@
+// Transcript clean-up, command matching, and the compression ratio estimate whose
+// hallucination threshold (2.4) was tuned on zlib ratios
+#include "text_processing.h"
+#include "check.h"
+#include <string>
+
+static void testCompressionRatioTracksZlib() {
+    // Reference ratios from Python's len(text) / len(zlib.compress(text))
+    struct Sample {
+        const char* text;
+        double zlibRatio;
+    };
+    const Sample samples[] = {
+        {"Hello world.", 0.600},
+        {" Okay.", 0.429},
+        {"The quick brown fox jumps over the lazy dog and then runs away into the forest where nobody can find it.",
+         1.156},
+        {" Thank you. Thank you. Thank you. Thank you. Thank you. Thank you. Thank you.", 3.500},
+        {" So, so, so, so, so, so, so, so, so, so, so, so, so, so, so, so, so, so.", 4.235},
+        {" the the the the the the the the the the the the the the the the the the the the the the the the the the the",
+         7.200},
+    };
+    for (const Sample& sample : samples) {
+        double ratio = textCompressionRatio(sample.text);
+        CHECK_NEAR(ratio / sample.zlibRatio, 1.0, 0.08);
+    }
+    CHECK(textCompressionRatio("") == 0.0f);
+}
+
+static void testCompressionRatioThreshold() {
+    const float threshold = 2.4f;
+    CHECK(textCompressionRatio(" Move the mouse up fifty pixels and then click on the button.") < threshold);
+    CHECK(textCompressionRatio(" In this meeting we discussed the quarterly results, the hiring plan for next "
+                               "year, and the roadmap for the mobile application.") < threshold);
+    CHECK(textCompressionRatio(" I'm going to go to the store. I'm going to go to the store. I'm going to go "
+                               "to the store. I'm going to go to the store.") > threshold);
+}
+
+static void testCleanTranscription() {
+    CHECK(cleanTranscription(" [BLANK_AUDIO] ") == "");
+    CHECK(cleanTranscription("Hello [typing] world  ") == "Hello world");
+    CHECK(cleanTranscription("  plain   text ") == "plain text");
+}
+
+static void testCommandMatching() {
+    CHECK(normalizeText("Jarvis, Stop Listening!") == "jarvis stop listening");
+    CHECK(containsAnyCommand(normalizeText("OK, Jarvis stop listening."), {"jarvis stop listening"}));
+    CHECK(!containsAnyCommand(normalizeText("Keep typing please."), {"jarvis stop listening", "mouse mode"}));
+}
+
+static void testMergeContinuousText() {
+    CHECK(mergeContinuousText("", "hello there") == "hello there");
+    std::string merged = mergeContinuousText("we went to the", "to the store");
+    CHECK(merged.find("to the to the") == std::string::npos);
+    CHECK(merged.find("store") != std::string::npos);
+}
+
+int main() {
+    testCompressionRatioTracksZlib();
+    testCompressionRatioThreshold();
+    testCleanTranscription();
+    testCommandMatching();
+    testMergeContinuousText();
+    return checkResult("test_text_processing");
+}
@@ -0,0 +1,164 @@
+// The model-free helpers of the transcription path: encoder context sizing, the
+// voicing measure and no-speech probability the speech gate decides on, the split
+// planner for long recordings, and submitting a split while the model is still loading
+#include "transcription.h"
+#include "check.h"
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+static void testComputeAudioCtx() {
+    const int rate = 16000;
+    // 1 s + 200 ms margin is 60 encoder frames, rounded up to the granularity
+    CHECK(computeAudioCtx(rate, rate, 200, 64) == 64);
+    CHECK(computeAudioCtx(rate, rate, 200, 1) == 60);
+    CHECK(computeAudioCtx(3 * rate, rate, 500, 64) == 192);
+    CHECK(computeAudioCtx(rate / 2, rate, 0, 32) == 32);
+
+    // Anything that needs the whole 30 s window uses full context (0)
+    CHECK(computeAudioCtx(30 * rate, rate, 0, 64) == 0);
+    CHECK(computeAudioCtx(29 * rate, rate, 1000, 64) == 0);
+    CHECK(computeAudioCtx(28 * rate, rate, 0, 64) == 1408);
+
+    // Bad parameters fall back to full context
+    CHECK(computeAudioCtx(rate, 0, 200, 64) == 0);
+    CHECK(computeAudioCtx(rate, rate, 200, 0) == 0);
+}
+
+static void testMeasureVoicing() {
+    const int rate = 16000;
+    const size_t frame = rate / 50;
+
+    // 10 frames: 4 of a loud low tone, 3 of quiet tone, 3 of loud alternating-sign noise
+    std::vector<float> samples(10 * frame, 0.0f);
+    for (size_t i = 0; i < samples.size(); i++) {
+        size_t index = i / frame;
+        if (index < 4) {
+            samples[i] = 0.2f * std::sin(2.0f * 3.14159265f * 200.0f * i / rate);
+        } else if (index < 7) {
+            samples[i] = 0.001f * std::sin(2.0f * 3.14159265f * 200.0f * i / rate);
+        } else {
+            samples[i] = (i % 2 == 0) ? 0.2f : -0.2f;
+        }
+    }
+
+    VoicingStats voicing = measureVoicing(samples.data(), samples.size(), rate, 0.02f, 0.3f);
+    CHECK(voicing.frames == 10);
+    CHECK(voicing.voicedFrames == 4);
+    CHECK(voicing.rms > 0.1f && voicing.rms < 0.2f);
+
+    // Without the zero-crossing limit the noise frames count too
+    CHECK(measureVoicing(samples.data(), samples.size(), rate, 0.02f, 0.0f).voicedFrames == 7);
+
+    // A lower threshold (push-to-talk's silence level) also admits the quiet frames
+    CHECK(measureVoicing(samples.data(), samples.size(), rate, 0.0005f, 0.3f).voicedFrames == 7);
+
+    CHECK(measureVoicing(nullptr, 0, rate, 0.02f, 0.3f).frames == 0);
+}
+
+static void testNoSpeechProbability() {
+    // Uniform logits: every token, the no-speech one included, gets 1 / vocabulary
+    std::vector<float> logits(1000, 2.0f);
+    CHECK_NEAR(noSpeechProbability(logits.data(), 1000, 7), 0.001f, 1e-6f);
+
+    // A dominant no-speech logit takes nearly all the mass, even with large logits elsewhere
+    logits[7] = 120.0f;
+    logits[8] = 100.0f;
+    CHECK(noSpeechProbability(logits.data(), 1000, 7) > 0.99f);
+    CHECK(noSpeechProbability(logits.data(), 1000, 8) < 0.01f);
+
+    // e^1 : (e^1 + e^0): the softmax of two logits one apart
+    float pair[2] = {1.0f, 0.0f};
+    CHECK_NEAR(noSpeechProbability(pair, 2, 0), 0.7310586f, 1e-5f);
+
+    // No logits or a token outside the vocabulary
+    CHECK(noSpeechProbability(nullptr, 1000, 7) == 0.0f);
+    CHECK(noSpeechProbability(logits.data(), 1000, 1000) == 0.0f);
+}
+
+static std::vector<float> makeSpeechLike(double seconds) {
+    std::vector<float> samples(static_cast<size_t>(seconds * 16000));
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = 0.2f * std::sin(0.05f * i) * (1.0f + 0.5f * std::sin(0.0007f * i));
+    }
+    return samples;
+}
+
+static void testPlanSplit() {
+    const size_t rate = 16000;
+    Settings::ParallelSplitSettings split = Settings().parallelSplit;
+    split.enabled = true;
+    split.minRecordingSec = 12.0f;
+    split.minWindowSec = 6.0f;
+    split.maxWindowSec = 28.0f;
+    split.searchMs = 1500;
+
+    // Short recordings, a single decoder or a disabled split decode whole
+    CHECK(planSplit(makeSpeechLike(10.0), 4, split).empty());
+    CHECK(planSplit(makeSpeechLike(20.0), 1, split).empty());
+    Settings::ParallelSplitSettings disabled = split;
+    disabled.enabled = false;
+    CHECK(planSplit(makeSpeechLike(20.0), 4, disabled).empty());
+
+    // Two decoders: one cut, moved from the midpoint to the quiet stretch at 9.5 s
+    std::vector<float> samples = makeSpeechLike(20.0);
+    for (size_t i = 9 * rate + rate / 2; i < 9 * rate + rate / 2 + 640; i++) {
+        samples[i] = 0.0f;
+    }
+    std::vector<size_t> cuts = planSplit(samples, 2, split);
+    CHECK(cuts.size() == 1);
+    if (cuts.size() == 1) {
+        CHECK(cuts[0] >= 9 * rate + rate / 2 && cuts[0] <= 9 * rate + rate / 2 + 640);
+    }
+
+    // More audio than two maximum windows needs a third, whatever the decoder count
+    samples = makeSpeechLike(70.0);
+    cuts = planSplit(samples, 2, split);
+    CHECK(cuts.size() == 2);
+    size_t previous = 0;
+    cuts.push_back(samples.size());
+    for (size_t cut : cuts) {
+        CHECK(cut > previous);
+        CHECK(cut - previous <= static_cast<size_t>(split.maxWindowSec * rate));
+        CHECK(cut - previous >= static_cast<size_t>(split.minWindowSec * rate / 2));
+        previous = cut;
+    }
+}
+
+// Without init() the model stays loading, so nothing is decoded and nothing frees
+// queue space: a split recording must still be accepted at once
+static void testSplitSubmitDoesNotBlock() {
+    Settings settings;
+    settings.parallelDecoders = 2;
+    settings.maxQueuedJobs = 4;
+    settings.parallelSplit.enabled = true;
+    settings.speechGate.enabled = false;
+    Transcription transcription(settings);
+
+    // 300 s in windows of at most 28 s: 11 windows, well past the 4 queue slots
+    AudioChunk chunk;
+    chunk.samples = makeSpeechLike(300.0);
+    size_t windows = planSplit(chunk.samples, 2, settings.parallelSplit).size() + 1;
+    CHECK(windows == 11);
+
+    auto start = std::chrono::steady_clock::now();
+    std::future<TranscriptionResult> result = transcription.submit(std::move(chunk));
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    CHECK(ms < 5000.0);
+    CHECK(transcription.pendingJobs() == windows);
+    CHECK(result.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+
+    // The windows don't take the bounded queue's slots
+    AudioChunk shortChunk;
+    shortChunk.samples = makeSpeechLike(2.0);
+    CHECK(transcription.canSubmit(shortChunk));
+}
+
+int main() {
+    testComputeAudioCtx();
+    testMeasureVoicing();
+    testNoSpeechProbability();
+    testPlanSplit();
+    testSplitSubmitDoesNotBlock();
+    return checkResult("test_transcription_helpers");
+}